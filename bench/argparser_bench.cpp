@@ -0,0 +1,304 @@
+#include <lib/ArgParser.h>
+#include <tests/AllocationCounter.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <getopt.h>
+
+/*
+    Parser throughput benchmarks. Every scenario is deterministic (no
+    random input) and runs a fixed number of iterations after one warm-up
+    parse. The memory scenarios report ArgParser::MemoryUsage for growing
+    schemas after a parse and a help render. Results are printed as JSON
+    to stdout:
+
+    argparser_bench [--quick]
+*/
+
+namespace {
+
+using ArgumentParser::ArgParser;
+
+struct Result {
+    std::string name;
+    size_t iterations;
+    size_t tokens;
+    double ns_per_iteration;
+    double ns_per_token;
+    double allocations_per_iteration;
+};
+
+struct MemoryResult {
+    int options;
+    ArgumentParser::MemoryReport report;
+};
+
+// Runs body iterations times after one warm-up call; tokens is the number
+// of tokens handled by a single call
+Result Measure(const std::string& name, size_t iterations, size_t tokens,
+    const std::function<void()>& body)
+{
+    body();
+    size_t allocations = AllocationCounter::Count();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        body();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    allocations = AllocationCounter::Count() - allocations;
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    return Result{name, iterations, tokens, ns, tokens == 0 ? 0.0 : ns / tokens,
+        static_cast<double>(allocations) / iterations};
+}
+
+void Check(bool is_ok, const std::string& scenario) {
+    if (!is_ok) {
+        std::cerr << "Scenario " << scenario << " failed to parse" << std::endl;
+        std::exit(1);
+    }
+}
+
+std::string OptionName(int ind) {
+    return "option" + std::to_string(ind);
+}
+
+std::vector<std::string> WideSchemaArgs(int used) {
+    std::vector<std::string> args = {"app"};
+    for (int i = 0; i < used; ++i) {
+        args.push_back("--" + OptionName(i * 97 % 1000) + "=" + std::to_string(i));
+    }
+    return args;
+}
+
+Result EmptyParse(size_t iterations) {
+    ArgParser parser("bench");
+    std::vector<std::string> args = {"app"};
+    return Measure("empty_parse", iterations, 0, [&] {
+        Check(parser.Parse(args), "empty_parse");
+    });
+}
+
+Result WideSchema(size_t iterations) {
+    ArgParser parser("bench");
+    for (int i = 0; i < 1000; ++i) {
+        parser.AddIntArgument(OptionName(i)).Default(0);
+    }
+    std::vector<std::string> args = WideSchemaArgs(10);
+    return Measure("schema_1k_used_10", iterations, args.size() - 1, [&] {
+        Check(parser.Parse(args), "schema_1k_used_10");
+    });
+}
+
+Result WideSchemaGetopt(size_t iterations) {
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; ++i) {
+        names.push_back(OptionName(i));
+    }
+    std::vector<option> options;
+    for (size_t i = 0; i < names.size(); ++i) {
+        options.push_back(option{names[i].c_str(), required_argument, nullptr,
+            1000 + static_cast<int>(i)});
+    }
+    options.push_back(option{nullptr, 0, nullptr, 0});
+    std::vector<std::string> args = WideSchemaArgs(10);
+    std::vector<int> values(names.size());
+    return Measure("getopt_long_schema_1k_used_10", iterations, args.size() - 1, [&] {
+        std::vector<char*> argv;
+        for (std::string& arg : args) {
+            argv.push_back(arg.data());
+        }
+        argv.push_back(nullptr);
+        optind = 0;
+        int ret;
+        while ((ret = getopt_long(argv.size() - 1, argv.data(), "", options.data(), nullptr)) != -1) {
+            values[ret - 1000] = std::atoi(optarg);
+        }
+    });
+}
+
+Result PositionalInts(size_t iterations, size_t count) {
+    ArgParser parser("bench");
+    std::vector<int> values;
+    parser.AddIntArgument("N").MultiValue(1).Positional().StoreValues(values);
+    std::vector<std::string> args = {"app"};
+    for (size_t i = 0; i < count; ++i) {
+        args.push_back(std::to_string(i));
+    }
+    return Measure("positional_ints", iterations, count, [&] {
+        Check(parser.Parse(args), "positional_ints");
+    });
+}
+
+Result LongStrings(size_t iterations, size_t count) {
+    ArgParser parser("bench");
+    parser.AddStringArgument("paths").MultiValue(1).Positional();
+    std::vector<std::string> args = {"app"};
+    for (size_t i = 0; i < count; ++i) {
+        args.push_back("/very/long/path/to/some/deeply/nested/directory/" + std::string(64, 'x') +
+            "/file" + std::to_string(i));
+    }
+    return Measure("long_strings", iterations, count, [&] {
+        Check(parser.Parse(args), "long_strings");
+    });
+}
+
+Result ClusteredFlags(size_t iterations, size_t count) {
+    ArgParser parser("bench");
+    const std::string flags = "abcdefghijklmnopqrstuvwxyz";
+    for (char flag : flags) {
+        parser.AddFlag(flag, std::string("flag_") + flag);
+    }
+    std::vector<std::string> args = {"app"};
+    for (size_t i = 0; i < count; ++i) {
+        args.push_back("-" + flags);
+    }
+    return Measure("clustered_short_flags", iterations, count, [&] {
+        Check(parser.Parse(args), "clustered_short_flags");
+    });
+}
+
+Result ClusteredFlagsGetopt(size_t iterations, size_t count) {
+    const std::string flags = "abcdefghijklmnopqrstuvwxyz";
+    std::vector<std::string> args = {"app"};
+    for (size_t i = 0; i < count; ++i) {
+        args.push_back("-" + flags);
+    }
+    bool seen[256] = {};
+    return Measure("getopt_long_clustered_short_flags", iterations, count, [&] {
+        std::vector<char*> argv;
+        for (std::string& arg : args) {
+            argv.push_back(arg.data());
+        }
+        argv.push_back(nullptr);
+        optind = 0;
+        int ret;
+        while ((ret = getopt_long(argv.size() - 1, argv.data(), flags.c_str(), nullptr, nullptr)) != -1) {
+            seen[static_cast<unsigned char>(ret)] = true;
+        }
+    });
+}
+
+void RegisterOptions(ArgParser& parser, int options) {
+    for (int i = 0; i < options; ++i) {
+        parser.AddIntArgument(OptionName(i), "Description of option number " + std::to_string(i))
+            .Default(i);
+    }
+}
+
+Result HelpLargeSchema(size_t iterations, int options) {
+    ArgParser parser("bench");
+    parser.AddHelp('h', "help", "Benchmark of the help rendering");
+    RegisterOptions(parser, options);
+    int width = 80;
+    return Measure("help_description_" + std::to_string(options), iterations, options, [&] {
+        // A new width invalidates the cached text, so every call renders
+        parser.SetHelpWidth(width++ % 2 == 0 ? 80 : 100);
+        if (parser.HelpDescription().empty()) {
+            std::exit(1);
+        }
+    });
+}
+
+// Building a parser from code, the baseline of SchemaLoad
+Result SchemaRegister(size_t iterations, int options) {
+    return Measure("schema_register_" + std::to_string(options), iterations, options, [&] {
+        ArgParser parser("bench");
+        RegisterOptions(parser, options);
+    });
+}
+
+Result SchemaLoad(size_t iterations, int options) {
+    ArgParser source("bench");
+    RegisterOptions(source, options);
+    std::string blob = source.SerializeSchema();
+    std::uint64_t hash = source.SchemaHash();
+    return Measure("schema_load_" + std::to_string(options), iterations, options, [&] {
+        ArgParser parser("bench");
+        Check(parser.LoadSchema(blob, hash), "schema_load");
+    });
+}
+
+// Every tenth option is a MultiValue string list, the others are ints
+// with a default; all options get a value, so value storage is filled
+MemoryResult SchemaMemory(int options) {
+    ArgParser parser("bench");
+    parser.AddHelp('h', "help", "Benchmark of the memory report");
+    std::vector<std::string> args = {"app"};
+    for (int i = 0; i < options; ++i) {
+        std::string description = "Description of option number " + std::to_string(i);
+        if (i % 10 == 0) {
+            parser.AddStringArgument(OptionName(i), description).MultiValue(0);
+            args.push_back("--" + OptionName(i) + "=value_of_option_" + std::to_string(i));
+        } else {
+            parser.AddIntArgument(OptionName(i), description).Default(0);
+            args.push_back("--" + OptionName(i) + "=" + std::to_string(i));
+        }
+    }
+    Check(parser.Parse(args), "memory_" + std::to_string(options));
+    parser.HelpText();
+    return MemoryResult{options, parser.MemoryUsage()};
+}
+
+void PrintJson(const std::vector<Result>& results, const std::vector<MemoryResult>& memory) {
+    std::cout << "{\n";
+#ifdef ARGPARSER_BUILD_TYPE
+    std::cout << "  \"build_type\": \"" << ARGPARSER_BUILD_TYPE << "\",\n";
+#endif
+    std::cout << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        std::cout << "    {\"name\": \"" << result.name << "\""
+            << ", \"iterations\": " << result.iterations
+            << ", \"tokens\": " << result.tokens
+            << ", \"ns_per_iteration\": " << result.ns_per_iteration
+            << ", \"ns_per_token\": " << result.ns_per_token
+            << ", \"allocations_per_iteration\": " << result.allocations_per_iteration
+            << "}" << (i + 1 == results.size() ? "\n" : ",\n");
+    }
+    std::cout << "  ],\n";
+    std::cout << "  \"memory\": [\n";
+    for (size_t i = 0; i < memory.size(); ++i) {
+        const ArgumentParser::MemoryReport& report = memory[i].report;
+        std::cout << "    {\"options\": " << memory[i].options
+            << ", \"total\": " << report.Total()
+            << ", \"schema\": " << report.schema
+            << ", \"name_index\": " << report.name_index
+            << ", \"help_text\": " << report.help_text
+            << ", \"value_storage\": " << report.value_storage
+            << ", \"parse_buffers\": " << report.parse_buffers
+            << ", \"bytes_per_option\": " << report.Total() / memory[i].options
+            << "}" << (i + 1 == memory.size() ? "\n" : ",\n");
+    }
+    std::cout << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool quick = argc > 1 && std::strcmp(argv[1], "--quick") == 0;
+    size_t scale = quick ? 10 : 1;
+
+    std::vector<Result> results;
+    results.push_back(EmptyParse(100000 / scale));
+    results.push_back(WideSchema(10000 / scale));
+    results.push_back(WideSchemaGetopt(10000 / scale));
+    results.push_back(PositionalInts(quick ? 1 : 5, 1000000 / scale));
+    results.push_back(LongStrings(quick ? 1 : 5, 100000 / scale));
+    results.push_back(ClusteredFlags(100 / scale, 10000));
+    results.push_back(ClusteredFlagsGetopt(100 / scale, 10000));
+    results.push_back(HelpLargeSchema(quick ? 2 : 20, 10000));
+    results.push_back(SchemaRegister(1000 / scale, 1000));
+    results.push_back(SchemaLoad(1000 / scale, 1000));
+    std::vector<MemoryResult> memory;
+    for (int options : {10, 100, 1000, 10000}) {
+        memory.push_back(SchemaMemory(options));
+    }
+    PrintJson(results, memory);
+    return 0;
+}
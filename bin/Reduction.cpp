@@ -0,0 +1,128 @@
+#include "Reduction.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Below this many values per thread starting threads costs more than it saves
+const size_t kMinChunkSize = 1 << 16;
+
+// A sum of int32 values over a chunk this long always fits into int64,
+// so the inner loop needs no overflow checks and vectorizes
+const size_t kMaxUncheckedSum = size_t(1) << 32;
+
+struct Partial {
+    std::int64_t value = 0;
+    bool overflow = false;
+    bool has_zero = false;
+};
+
+Partial SumChunk(std::span<const int> values) {
+    Partial ret;
+    for (size_t first = 0; first < values.size(); first += kMaxUncheckedSum) {
+        std::span<const int> part = values.subspan(first,
+            std::min(kMaxUncheckedSum, values.size() - first));
+        std::int64_t sum = 0;
+        for (int value : part) {
+            sum += value;
+        }
+        ret.overflow |= __builtin_add_overflow(ret.value, sum, &ret.value);
+    }
+    return ret;
+}
+
+Partial MultChunk(std::span<const int> values) {
+    Partial ret{1};
+    for (int value : values) {
+        if (value == 0) {
+            ret.has_zero = true;
+            return ret;
+        }
+        ret.overflow |= __builtin_mul_overflow(ret.value, value, &ret.value);
+    }
+    return ret;
+}
+
+Partial ReduceChunk(std::span<const int> values, ReductionOp op) {
+    switch (op) {
+    case ReductionOp::kMult:
+        return MultChunk(values);
+    case ReductionOp::kMin:
+        return Partial{*std::min_element(values.begin(), values.end())};
+    case ReductionOp::kMax:
+        return Partial{*std::max_element(values.begin(), values.end())};
+    case ReductionOp::kSum:
+    case ReductionOp::kMean:
+    default:
+        return SumChunk(values);
+    }
+}
+
+Partial Combine(Partial lhs, const Partial& rhs, ReductionOp op) {
+    lhs.has_zero |= rhs.has_zero;
+    lhs.overflow |= rhs.overflow;
+    switch (op) {
+    case ReductionOp::kMult:
+        lhs.overflow |= __builtin_mul_overflow(lhs.value, rhs.value, &lhs.value);
+        break;
+    case ReductionOp::kMin:
+        lhs.value = std::min(lhs.value, rhs.value);
+        break;
+    case ReductionOp::kMax:
+        lhs.value = std::max(lhs.value, rhs.value);
+        break;
+    case ReductionOp::kSum:
+    case ReductionOp::kMean:
+    default:
+        lhs.overflow |= __builtin_add_overflow(lhs.value, rhs.value, &lhs.value);
+        break;
+    }
+    return lhs;
+}
+
+} // namespace
+
+ReductionResult Reduce(std::span<const int> values, ReductionOp op, int threads) {
+    ReductionResult ret;
+    if (values.empty()) {
+        ret.value = op == ReductionOp::kMult ? 1 : 0;
+        return ret;
+    }
+    size_t chunks = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    chunks = std::clamp<size_t>(values.size() / kMinChunkSize, 1, chunks);
+    // Chunk i is [i * n / chunks, (i + 1) * n / chunks), never empty
+    auto chunk = [&values, chunks](size_t i) {
+        size_t first = i * values.size() / chunks;
+        return values.subspan(first, (i + 1) * values.size() / chunks - first);
+    };
+
+    std::vector<Partial> partials(chunks);
+    std::vector<std::thread> workers;
+    workers.reserve(chunks - 1);
+    for (size_t i = 1; i < chunks; ++i) {
+        workers.emplace_back([&partials, &chunk, op, i]() {
+            partials[i] = ReduceChunk(chunk(i), op);
+        });
+    }
+    partials[0] = ReduceChunk(chunk(0), op);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    Partial total = partials[0];
+    for (size_t i = 1; i < chunks; ++i) {
+        total = Combine(total, partials[i], op);
+    }
+    // A zero factor wins over an overflow anywhere else
+    if (op == ReductionOp::kMult && total.has_zero) {
+        return ret;
+    }
+    ret.value = total.value;
+    ret.overflow = total.overflow;
+    if (op == ReductionOp::kMean) {
+        ret.mean = static_cast<double>(total.value) / values.size();
+    }
+    return ret;
+}
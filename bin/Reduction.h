@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+enum class ReductionOp {
+    kSum = 0,
+    kMult,
+    kMin,
+    kMax,
+    kMean
+};
+
+// value holds the sum, product, minimum or maximum, mean only the mean.
+// overflow is set when a sum or a product does not fit into int64.
+struct ReductionResult {
+    std::int64_t value = 0;
+    double mean = 0;
+    bool overflow = false;
+};
+
+// Splits values into contiguous chunks, reduces them on up to threads
+// threads (0 means one per core) and combines the partial results in
+// chunk order. Small inputs are reduced on the calling thread.
+ReductionResult Reduce(std::span<const int> values, ReductionOp op, int threads = 0);
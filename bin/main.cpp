@@ -1,44 +1,71 @@
-#include <functional>
 #include <lib/ArgParser.h>
 
+#include "Reduction.h"
+
 #include <iostream>
-#include <numeric>
 
 struct Options {
+    std::vector<int> values;
     bool sum = false;
     bool mult = false;
+    bool min = false;
+    bool max = false;
+    bool mean = false;
+    int threads = 0;
 };
 
 int main(int argc, char** argv) {
     Options opt;
-    std::vector<int> values;
 
     ArgumentParser::ArgParser parser("Program");
-    parser.AddIntArgument("N").MultiValue(1).Positional().StoreValues(values);
-    parser.AddFlag("sum", "add args").StoreValue(opt.sum);
-    parser.AddFlag("mult", "multiply args").StoreValue(opt.mult);
+    auto bind = parser.Bind(opt);
+    bind.Int("N", &Options::values).MultiValue(1).Positional();
+    bind.Flag("sum", &Options::sum, "add args");
+    bind.Flag("mult", &Options::mult, "multiply args");
+    bind.Flag("min", &Options::min, "smallest arg");
+    bind.Flag("max", &Options::max, "largest arg");
+    bind.Flag("mean", &Options::mean, "arithmetic mean of args");
+    bind.Int("threads", &Options::threads, "worker threads, 0 means one per core").Default(0);
     parser.AddHelp('h', "help", "Program accumulate arguments");
 
     if(!parser.Parse(argc, argv)) {
         std::cout << "Wrong argument" << std::endl;
-        std::cout << parser.HelpDescription() << std::endl;
+        parser.WriteHelp(std::cout);
         return 1;
     }
 
     if(parser.Help()) {
-        std::cout << parser.HelpDescription() << std::endl;
+        parser.WriteHelp(std::cout);
         return 0;
     }
 
+    ReductionOp op;
     if(opt.sum) {
-        std::cout << "Result: " << std::accumulate(values.begin(), values.end(), 0) << std::endl;
+        op = ReductionOp::kSum;
     } else if(opt.mult) {
-        std::cout << "Result: " << std::accumulate(values.begin(), values.end(), 1, std::multiplies<int>()) << std::endl;
+        op = ReductionOp::kMult;
+    } else if(opt.min) {
+        op = ReductionOp::kMin;
+    } else if(opt.max) {
+        op = ReductionOp::kMax;
+    } else if(opt.mean) {
+        op = ReductionOp::kMean;
     } else {
         std::cout << "No one options had chosen" << std::endl;
-        std::cout << parser.HelpDescription();
+        parser.WriteHelp(std::cout);
+        return 1;
+    }
+
+    ReductionResult result = Reduce(opt.values, op, opt.threads);
+    if(result.overflow) {
+        std::cout << "Result does not fit into 64-bit integer" << std::endl;
         return 1;
     }
+    if(op == ReductionOp::kMean) {
+        std::cout << "Result: " << result.mean << std::endl;
+    } else {
+        std::cout << "Result: " << result.value << std::endl;
+    }
 
     return 0;
 
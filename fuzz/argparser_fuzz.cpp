@@ -0,0 +1,191 @@
+#include <lib/ArgParser.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+    Fuzz target of ArgParser::Parse. The first input byte picks parser
+    options, the rest is split on '\0' into command line tokens.
+
+    With clang it is a libFuzzer target (-DARGPARSER_LIBFUZZER). Otherwise
+    it is built with a standalone driver:
+
+    argparser_fuzz [--runs N] [--seed S] [files...]
+
+    Every file is run as one input; without files N inputs are generated
+    from the seed.
+*/
+
+namespace {
+
+using ArgumentParser::ArgParser;
+
+const uint8_t kOptionAbbreviations = 1 << 0;
+const uint8_t kOptionSubcommand = 1 << 1;
+const uint8_t kOptionRequired = 1 << 2;
+
+void BuildParser(ArgParser& parser, uint8_t options) {
+    parser.AddHelp('h', "help", "Fuzzed parser");
+    parser.AddFlag('a', "all");
+    parser.AddFlag('b', "brief").Default(true);
+    parser.AddFlag('\xff', "high");
+    parser.AddIntArgument('n', "number").MultiValue(0);
+    parser.AddIntArgument("numeric").Default(0).Range(-1000, 1000);
+    parser.AddStringArgument('s', "string").Default("value");
+    if (options & kOptionRequired) {
+        parser.AddStringArgument("required");
+    }
+    parser.AddIntArgument("values").MultiValue(0).Positional();
+    if (options & kOptionAbbreviations) {
+        parser.AllowAbbreviations();
+    }
+    if (options & kOptionSubcommand) {
+        parser.AddSubcommand("sub", [](ArgParser& subparser) {
+            subparser.AddFlag('v', "verbose");
+            subparser.AddStringArgument("path").MultiValue(0);
+        });
+    }
+}
+
+void Check(bool condition, const char* what) {
+    if (!condition) {
+        std::cerr << "Invariant failed: " << what << std::endl;
+        std::abort();
+    }
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    uint8_t options = data[0];
+    std::vector<std::string> args = {"app"};
+    std::string token;
+    for (size_t i = 1; i < size; ++i) {
+        if (data[i] == '\0') {
+            args.push_back(std::move(token));
+            token.clear();
+        } else {
+            token += static_cast<char>(data[i]);
+        }
+    }
+    args.push_back(std::move(token));
+
+    ArgParser parser("fuzz");
+    BuildParser(parser, options);
+    bool is_ok = parser.Parse(args);
+    std::string message = parser.GetErrorMessage();
+    Check(is_ok || !message.empty() || parser.Help(), "a failed parse reports an error");
+
+    // A reused parser must not remember anything from the previous input
+    Check(parser.Parse({"app", "-a", "--string=x", "1", "2"}) == !(options & kOptionRequired),
+        "reset between parses");
+    Check(parser.Parse(args) == is_ok, "same input, same result");
+    Check(parser.GetErrorMessage() == message, "same input, same error");
+
+    // The same bytes as one shell-quoted command line
+    parser.ParseCommandLine(std::string_view(reinterpret_cast<const char*>(data) + 1, size - 1));
+
+    ArgParser fresh("fuzz");
+    BuildParser(fresh, options);
+    Check(fresh.Parse(args) == is_ok, "reused and fresh parsers agree");
+
+    // The parallel pre-pass (on a single chunk here) must not change anything
+    ArgParser prepassed("fuzz");
+    BuildParser(prepassed, options);
+    prepassed.SetParallelThreshold(1);
+    Check(prepassed.Parse(args) == is_ok, "pre-pass and serial parse agree");
+    Check(prepassed.GetErrorMessage() == message, "pre-pass and serial parse report the same error");
+
+    // The second parse of args is a cache hit unless a subcommand was selected
+    ArgParser cached("fuzz");
+    BuildParser(cached, options);
+    cached.EnableResultCache(2);
+    Check(cached.Parse(args) == is_ok, "cached parse on a miss agrees");
+    cached.Parse({"app"});
+    Check(cached.Parse(args) == is_ok, "cached parse on a hit agrees");
+    Check(cached.GetErrorMessage() == message, "cached parse reports the same error");
+    Check(cached.HasSubcommand() || cached.SerializeResult() == fresh.SerializeResult(),
+        "cache hit restores the parse result");
+
+    // Incremental re-parse to args without its last token
+    std::vector<std::string> changed;
+    std::vector<std::string> shorter(args.begin(), args.end() - 1);
+    parser.Parse(args);
+    bool is_reparse_ok = parser.Reparse(args, shorter, changed);
+    Check(is_reparse_ok == fresh.Parse(shorter), "reparse and parse agree");
+    Check(is_reparse_ok || parser.GetParseError().code == fresh.GetParseError().code,
+        "reparse and parse report the same error");
+    return 0;
+}
+
+#ifndef ARGPARSER_LIBFUZZER
+
+namespace {
+
+// Mostly printable tokens built around the schema names, so that the
+// random inputs reach every branch of the parse loop
+std::string GenerateInput(std::mt19937& gen) {
+    const std::vector<std::string> pieces = {
+        "-", "--", "=", "a", "b", "h", "n", "s", "\xff", "all", "brief", "help",
+        "high", "number", "numeric", "string", "required", "values", "sub",
+        "verbose", "path", "nu", "str", "0", "42", "-7", "2147483648", "x", " ", "'", "\"",
+        "\\", "#", "\n"};
+    std::string input(1, static_cast<char>(gen()));
+    int tokens = gen() % 12;
+    for (int i = 0; i < tokens; ++i) {
+        int parts = 1 + gen() % 4;
+        for (int j = 0; j < parts; ++j) {
+            if (gen() % 16 == 0) {
+                input += static_cast<char>(gen());
+            } else {
+                input += pieces[gen() % pieces.size()];
+            }
+        }
+        input += '\0';
+    }
+    return input;
+}
+
+void Run(const std::string& input) {
+    LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t runs = 10000;
+    unsigned seed = 0;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    for (const std::string& file : files) {
+        std::ifstream in(file, std::ios::binary);
+        Run(std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()));
+    }
+    if (files.empty()) {
+        std::mt19937 gen(seed);
+        for (size_t i = 0; i < runs; ++i) {
+            Run(GenerateInput(gen));
+        }
+    }
+    return 0;
+}
+
+#endif
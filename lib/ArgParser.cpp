@@ -1,5 +1,6 @@
 #include "ArgParser.h"
 
+#include <algorithm>
 #include <stdexcept>
 
 namespace ArgumentParser {
@@ -7,13 +8,44 @@ namespace ArgumentParser {
 const std::string ArgParser::kNullString = "";
 const std::string ArgParser::kNoneParamName = kNullString;
 const std::string ArgParser::kDefaultHelpDescription = "Display this help and exit";
+const std::string ArgParser::kEndOfOptions = "--";
+
+std::string_view ToString(ErrorCode code) {
+    switch (code) {
+    case ErrorCode::kOk:
+        return "No error";
+    case ErrorCode::kUnknownArgument:
+        return "Unknown option";
+    case ErrorCode::kInvalidValue:
+        return "Invalid value";
+    case ErrorCode::kNoPositional:
+        return "Unexpected value";
+    case ErrorCode::kMissingArgument:
+        return "Missing required argument";
+    case ErrorCode::kUnknownParam:
+        return "Unknown parameter";
+    case ErrorCode::kTypeMismatch:
+        return "Parameter has another type";
+    case ErrorCode::kNotInitialized:
+        return "Value is not initialized";
+    case ErrorCode::kIndexOutOfRange:
+        return "Value index is out of range";
+    case ErrorCode::kInvalidCommandLine:
+        return "Unterminated quote or escape in command line";
+    case ErrorCode::kInvalidUtf8:
+        return "Value is not valid UTF-8";
+    case ErrorCode::kAmbiguousArgument:
+        return "Ambiguous option";
+    case ErrorCode::kInvalidSchema:
+        return "Invalid argument schema";
+    }
+    return "Unknown error";
+}
 
 ArgParser::ArgParser(const std::string& name) {
     name_ = name;
-    name_to_argument_node_ = 
-        std::unordered_map<std::string, std::unique_ptr<Node>>();
     flag_to_name_ = 
-        std::vector<std::string>(kMaxFlagValue, kNoneParamName);
+        std::vector<std::string_view>(kMaxFlagValue, kNoneParamName);
 }
 
 
@@ -21,10 +53,11 @@ void ArgParser::AddHelp(const char flag, const std::string param_name,
     const std::string& description) 
 {
     CheckAddNewArg(flag, param_name);
-    AddArgument(flag, param_name, 
+    AddArgument(flag, Intern(param_name), 
         new HelpArg(kDefaultHelpDescription, flag));
     help_node_param_ = param_name;
     program_description_ = description;
+    node_context_->help_changed = true;
 }
 
 bool ArgParser::Help() {
@@ -32,17 +65,6 @@ bool ArgParser::Help() {
     return GetHelpArg().IsUsed();
 }
 
-std::string ArgParser::HelpDescription() {
-    std::string ret = "Parser name: " + name_ + "\n" +
-        program_description_ + "\n";
-    for (const auto& [param, ptr] : name_to_argument_node_) {
-        if (param == help_node_param_) continue;
-        ret += GetArgInfo(*ptr, param) + "\n";
-    }
-    ret += GetArgInfo(GetHelpArg(), help_node_param_);
-    return ret;
-}
-
 std::string ArgParser::GetStringValue(std::string param, int ind) {
     AssertType(ArgType::kStringArg, param);
     StringArg& arg = GetStringArg(param);
@@ -61,12 +83,80 @@ int ArgParser::GetIntValue(std::string param, int ind) {
     return arg.GetIntValue(ind);
 }
 
+const IntSet& ArgParser::GetIntSet(const std::string& param) {
+    AssertType(ArgType::kIntSetArg, param);
+    return GetIntSetArg(param).GetSet();
+}
+
+std::expected<void, ParseError> ArgParser::TryParse(const int argc, char** argv) {
+    return TryParse(std::vector<std::string>(argv, argv + argc));
+}
+
+std::expected<void, ParseError> ArgParser::TryParse(const std::vector<std::string>& args) {
+    bool is_ok = false;
+    try {
+        is_ok = Parse(args);
+    } catch (const std::runtime_error&) {
+        // Thrown only for schema mistakes, which every Parse would hit
+        // again, so the parser is left as is
+        good_parse_ = false;
+        parse_error_ = ParseError{ErrorCode::kInvalidSchema, kNoIndex};
+    }
+    if (!is_ok) {
+        return std::unexpected(GetParseError());
+    }
+    return {};
+}
+
+const ParseError& ArgParser::GetParseError() const {
+    if (parse_error_.code == ErrorCode::kOk && HasSubcommand()) {
+        return subcommands_.at(selected_subcommand_).parser->GetParseError();
+    }
+    return parse_error_;
+}
+
+std::expected<int, ErrorCode> ArgParser::TryGetIntValue(const std::string& param, int ind) const {
+    const Node* node = nullptr;
+    ErrorCode code = FindNode(param, ArgType::kIntArg, node);
+    if (code != ErrorCode::kOk) {
+        return std::unexpected(code);
+    }
+    return static_cast<const IntArg*>(node)->TryGetIntValue(ind);
+}
+
+std::expected<std::string_view, ErrorCode> ArgParser::TryGetStringValue(
+    const std::string& param, int ind) const
+{
+    const Node* node = nullptr;
+    ErrorCode code = FindNode(param, ArgType::kStringArg, node);
+    if (code != ErrorCode::kOk) {
+        return std::unexpected(code);
+    }
+    return static_cast<const StringArg*>(node)->TryGetStringValue(ind);
+}
+
+std::expected<bool, ErrorCode> ArgParser::TryGetFlag(const std::string& param) const {
+    const Node* node = nullptr;
+    ErrorCode code = FindNode(param, ArgType::kBoolArg, node);
+    if (code != ErrorCode::kOk) {
+        return std::unexpected(code);
+    }
+    return static_cast<const BoolArg*>(node)->GetValue();
+}
+
+std::expected<const IntSet*, ErrorCode> ArgParser::TryGetIntSet(const std::string& param) const {
+    const Node* node = nullptr;
+    ErrorCode code = FindNode(param, ArgType::kIntSetArg, node);
+    if (code != ErrorCode::kOk) {
+        return std::unexpected(code);
+    }
+    return &static_cast<const IntSetArg*>(node)->GetSet();
+}
+
 ArgParser::IntArg& ArgParser::AddIntArgument(const char flag, 
     const std::string& param_name, const std::string& description) 
 {
-    CheckAddNewArg(flag, param_name);
-    AddArgument(flag, param_name, new IntArg(description, flag));
-    return GetIntArg(param_name);
+    return RegisterInt(flag, Intern(param_name), Intern(description));
 }
 ArgParser::IntArg& ArgParser::AddIntArgument(const std::string& param_name, 
     const std::string& description) 
@@ -77,9 +167,7 @@ ArgParser::IntArg& ArgParser::AddIntArgument(const std::string& param_name,
 ArgParser::StringArg& ArgParser::AddStringArgument(const char flag,
     const std::string& param_name, const std::string& description)
 {
-    CheckAddNewArg(flag, param_name);
-    AddArgument(flag, param_name, new StringArg(description, flag));
-    return GetStringArg(param_name);
+    return RegisterString(flag, Intern(param_name), Intern(description));
 }
 ArgParser::StringArg& ArgParser::AddStringArgument(const std::string& param_name,
     const std::string& description)
@@ -87,12 +175,22 @@ ArgParser::StringArg& ArgParser::AddStringArgument(const std::string& param_name
     return AddStringArgument(kNoneFlag, param_name, description);
 }
 
+ArgParser::IntSetArg& ArgParser::AddIntSetArgument(const char flag,
+    const std::string& param_name, const std::string& description)
+{
+    return RegisterIntSet(flag, Intern(param_name), Intern(description));
+}
+
+ArgParser::IntSetArg& ArgParser::AddIntSetArgument(const std::string& param_name,
+    const std::string& description)
+{
+    return AddIntSetArgument(kNoneFlag, param_name, description);
+}
+
 ArgParser::BoolArg& ArgParser::AddFlag(const char flag, 
     const std::string& param_name, const std::string& description)
 {
-    CheckAddNewArg(flag, param_name);
-    AddArgument(flag, param_name, new BoolArg(description, flag));
-    return GetBoolArg(param_name);
+    return RegisterFlag(flag, Intern(param_name), Intern(description));
 }
 
 ArgParser::BoolArg& ArgParser::AddFlag(const std::string& param_name, 
@@ -101,8 +199,265 @@ ArgParser::BoolArg& ArgParser::AddFlag(const std::string& param_name,
     return AddFlag(kNoneFlag, param_name, description);
 }
 
-std::string ArgParser::GetParamByFlag(const char flag) const {
-    return flag_to_name_[flag];
+ArgParser::IntArg& ArgParser::RegisterInt(const char flag, std::string_view param_name,
+    std::string_view description)
+{
+    CheckAddNewArg(flag, param_name);
+    IntArg* arg = new IntArg(description, flag);
+    AddArgument(flag, param_name, arg);
+    return *arg;
+}
+
+ArgParser::StringArg& ArgParser::RegisterString(const char flag, std::string_view param_name,
+    std::string_view description)
+{
+    CheckAddNewArg(flag, param_name);
+    StringArg* arg = new StringArg(description, flag);
+    AddArgument(flag, param_name, arg);
+    return *arg;
+}
+
+ArgParser::BoolArg& ArgParser::RegisterFlag(const char flag, std::string_view param_name,
+    std::string_view description)
+{
+    CheckAddNewArg(flag, param_name);
+    BoolArg* arg = new BoolArg(description, flag);
+    AddArgument(flag, param_name, arg);
+    return *arg;
+}
+
+ArgParser::IntSetArg& ArgParser::RegisterIntSet(const char flag, std::string_view param_name,
+    std::string_view description)
+{
+    CheckAddNewArg(flag, param_name);
+    IntSetArg* arg = new IntSetArg(description, flag);
+    AddArgument(flag, param_name, arg);
+    return *arg;
+}
+
+std::string_view ArgParser::Intern(std::string_view val) {
+    if (val.empty()) {
+        return {};
+    }
+    return owned_strings_.emplace_back(val);
+}
+
+std::string_view ArgParser::GetParamByFlag(const char flag) const {
+    return flag_to_name_[static_cast<unsigned char>(flag)];
+}
+
+void ArgParser::AddSubcommand(const std::string& name, SubcommandFactory factory,
+    const std::string& description)
+{
+    if (subcommands_.contains(name)) {
+        throw std::runtime_error("Subcommand is duplicated: " + name);
+    }
+    subcommands_[name] = Subcommand{std::move(factory), description, nullptr};
+    node_context_->help_changed = true;
+    ++node_context_->schema_version;
+}
+
+void ArgParser::AllowAbbreviations(bool allow) {
+    allow_abbreviations_ = allow;
+    ++node_context_->schema_version;
+}
+
+void ArgParser::SetParallelThreshold(size_t min_tokens) {
+    parallel_threshold_ = min_tokens;
+}
+
+void ArgParser::EnableResultCache(size_t capacity) {
+    result_cache_.SetCapacity(capacity);
+}
+
+const ResultCacheStats& ArgParser::GetResultCacheStats() const {
+    return result_cache_.Stats();
+}
+
+std::vector<std::string> ArgParser::Complete(const std::string& prefix) {
+    BuildIndex();
+    std::string_view name = prefix;
+    if (name.starts_with("--")) {
+        name.remove_prefix(2);
+    }
+    auto [first, last] = long_names_.Range(name);
+    std::vector<std::string> ret;
+    ret.reserve(last - first);
+    for (auto it = first; it != last; ++it) {
+        ret.push_back("--" + *it);
+    }
+    return ret;
+}
+
+std::string ArgParser::CompletionOutput(const std::string& prefix, CompletionShell shell) {
+    std::string ret = kNullString;
+    for (const std::string& candidate : Complete(prefix)) {
+        if (shell == CompletionShell::kBash) {
+            ret += candidate + "\n";
+            continue;
+        }
+        // _describe format: "name:description", ':' in name escaped
+        for (char c : candidate) {
+            if (c == ':') ret += '\\';
+            ret += c;
+        }
+        std::string description = GetArg(candidate.substr(2)).GetDescription();
+        if (!description.empty()) {
+            ret += ":" + description;
+        }
+        ret += "\n";
+    }
+    return ret;
+}
+
+std::vector<std::string> ArgParser::SuggestParams(const std::string& name, int max_distance) {
+    // The tree is built once per schema and only when a lookup needs it
+    if (need_suggest_index_) {
+        std::vector<std::string> names;
+        names.reserve(name_to_argument_node_.size());
+        for (const auto& [param, ptr] : name_to_argument_node_) {
+            names.emplace_back(param);
+        }
+        suggest_index_.Build(names);
+        need_suggest_index_ = false;
+    }
+    std::vector<std::string> ret;
+    for (auto& [distance, param] : suggest_index_.Find(name, max_distance)) {
+        if (ret.size() == kMaxSuggestions) break;
+        ret.push_back(std::move(param));
+    }
+    return ret;
+}
+
+std::string ArgParser::GetErrorMessage() {
+    if (parse_error_.code == ErrorCode::kOk) {
+        if (HasSubcommand()) {
+            return GetSubparser(selected_subcommand_).GetErrorMessage();
+        }
+        return kNullString;
+    }
+    std::string ret(ToString(parse_error_.code));
+    if (parse_error_.code == ErrorCode::kUnknownArgument) {
+        ret += " --" + unknown_param_;
+        std::vector<std::string> suggestions = SuggestParams(unknown_param_);
+        for (int i = 0; i < suggestions.size(); ++i) {
+            ret += (i == 0 ? ". Did you mean --" : " or --") + suggestions[i];
+        }
+        if (!suggestions.empty()) {
+            ret += "?";
+        }
+    } else if (parse_error_.code == ErrorCode::kAmbiguousArgument) {
+        ret += " --" + unknown_param_;
+        auto [first, last] = long_names_.Range(unknown_param_);
+        for (auto it = first; it != last; ++it) {
+            ret += (it == first ? " could be --" : " or --") + *it;
+        }
+    } else if (parse_error_.code == ErrorCode::kMissingArgument) {
+        // The first registered one, whatever the map order
+        const Node* missing = nullptr;
+        std::string_view missing_param;
+        for (const auto& [param, ptr] : name_to_argument_node_) {
+            if (param != help_node_param_ && !ptr->IsOk() &&
+                (missing == nullptr || ptr->GetId() < missing->GetId()))
+            {
+                missing = ptr.get();
+                missing_param = param;
+            }
+        }
+        if (missing != nullptr) {
+            ret += " --";
+            ret += missing_param;
+        }
+    } else if (parse_error_.token_index != kNoIndex) {
+        ret += " at argument " + std::to_string(parse_error_.token_index);
+    }
+    return ret;
+}
+
+namespace {
+
+// Buckets plus one heap node per element: the value, the next pointer
+// and the cached hash
+template <typename Map>
+size_t MapBytes(const Map& map) {
+    return map.bucket_count() * sizeof(void*) +
+        map.size() * (sizeof(typename Map::value_type) + sizeof(void*) + sizeof(size_t));
+}
+
+} // namespace
+
+MemoryReport ArgParser::MemoryUsage(size_t top_count) const {
+    MemoryReport report;
+    std::vector<std::pair<std::string, size_t>> arguments;
+    arguments.reserve(name_to_argument_node_.size());
+    for (const auto& [param, ptr] : name_to_argument_node_) {
+        size_t schema_bytes = ptr->SchemaBytes();
+        size_t value_bytes = ptr->ValueBytes();
+        report.schema += schema_bytes;
+        report.value_storage += value_bytes;
+        arguments.emplace_back(param, schema_bytes + value_bytes);
+    }
+    report.schema += VectorBytes(flag_to_name_) + sizeof(NodeContext);
+    for (const std::string& str : owned_strings_) {
+        report.schema += sizeof(str) + StringBytes(str);
+    }
+    report.name_index = MapBytes(name_to_argument_node_) + MapBytes(subcommands_) +
+        long_names_.HeapBytes() + suggest_index_.HeapBytes();
+    report.help_text = StringBytes(help_text_) + StringBytes(program_description_);
+    report.parse_buffers = VectorBytes(prepass_.types) + VectorBytes(prepass_.ints) +
+        tokenizer_.HeapBytes() + VectorBytes(node_context_->touched) +
+        VectorBytes(required_mask_) + VectorBytes(used_mask_) +
+        VectorBytes(kept_trace_.trace.ops) + VectorBytes(kept_trace_.args) +
+        VectorBytes(trace_args_);
+    for (const std::string& arg : kept_trace_.args) {
+        report.parse_buffers += StringBytes(arg);
+    }
+    for (const std::string& arg : trace_args_) {
+        report.parse_buffers += StringBytes(arg);
+    }
+
+    for (const auto& [name, subcommand] : subcommands_) {
+        report.schema += StringBytes(name) + StringBytes(subcommand.description);
+        if (subcommand.parser == nullptr) {
+            continue;
+        }
+        MemoryReport sub_report = subcommand.parser->MemoryUsage(0);
+        report.schema += sizeof(ArgParser) + sub_report.schema;
+        report.name_index += sub_report.name_index;
+        report.help_text += sub_report.help_text;
+        report.value_storage += sub_report.value_storage;
+        report.parse_buffers += sub_report.parse_buffers;
+    }
+
+    size_t count = std::min(top_count, arguments.size());
+    std::partial_sort(arguments.begin(), arguments.begin() + count, arguments.end(),
+        [](const auto& lhs, const auto& rhs) {
+            return lhs.second != rhs.second ? lhs.second > rhs.second : lhs.first < rhs.first;
+        });
+    arguments.resize(count);
+    report.top_arguments = std::move(arguments);
+    return report;
+}
+
+bool ArgParser::HasSubcommand() const {
+    return selected_subcommand_ != kNoneParamName;
+}
+
+const std::string& ArgParser::GetSubcommand() const {
+    return selected_subcommand_;
+}
+
+ArgParser& ArgParser::GetSubparser(const std::string& name) {
+    auto it = subcommands_.find(name);
+    if (it == subcommands_.end()) {
+        throw std::runtime_error(name + " is not subcommand");
+    }
+    Subcommand& subcommand = it->second;
+    if (subcommand.parser == nullptr) {
+        subcommand.parser = std::make_unique<ArgParser>(name_ + " " + name);
+        subcommand.factory(*subcommand.parser);
+    }
+    return *subcommand.parser;
 }
 
 
@@ -113,7 +468,7 @@ void ArgParser::AssertType(ArgType type, const std::string &param_name) const {
     }
 }
 
-bool ArgParser::CheckType(ArgType type, const std::string& param_name) const {
+bool ArgParser::CheckType(ArgType type, std::string_view param_name) const {
     auto node = name_to_argument_node_.find(param_name);
     if (node == name_to_argument_node_.end()) {
         return false;
@@ -125,80 +480,174 @@ bool ArgParser::CheckType(ArgType type, const std::unique_ptr<Node>& node) const
     return node->GetType() == type; 
 }
 
-bool ArgParser::CheckPositional(const std::string& param_name) const {
+bool ArgParser::CheckPositional(std::string_view param_name) const {
     if (!CheckType(ArgType::kIntArg, param_name) &&
-        !CheckType(ArgType::kStringArg, param_name))
+        !CheckType(ArgType::kStringArg, param_name) &&
+        !CheckType(ArgType::kIntSetArg, param_name))
     {
         return false;
     }
-    return static_cast<PositionalNode&>(*name_to_argument_node_.at(param_name)).IsPositional();
+    return static_cast<PositionalNode&>(*name_to_argument_node_.find(param_name)->second)
+        .IsPositional();
 }
 
 bool ArgParser::CheckAddNewArg(const char flag, 
-    const std::string& param_name) const
+    std::string_view param_name) const
 {
     if (!CheckType(ArgType::kNone, param_name)) {
         return false;
     }
-    if (flag_to_name_[flag] != kNoneParamName) {
+    if (flag_to_name_[static_cast<unsigned char>(flag)] != kNoneParamName) {
         return false;
     }
     return true;
 }
 
 bool ArgParser::CheckArgsAreOk() {
-    for (const auto& [param, ptr] : name_to_argument_node_) {
-        if (param == help_node_param_) {
-            continue;
+    // Untouched nodes are in the reset state, so only the required ones
+    // among them can fail, and the mask catches those.
+    std::fill(used_mask_.begin(), used_mask_.end(), 0);
+    for (Node* node : node_context_->touched) {
+        if (!node->IsOk()) {
+            return false;
         }
-        if (!ptr->IsOk()) {
+        if (node->IsUsed()) {
+            used_mask_[node->GetId() / 64] |= 1ull << (node->GetId() % 64);
+        }
+    }
+    for (size_t i = 0; i < required_mask_.size(); ++i) {
+        if ((required_mask_[i] & ~used_mask_[i]) != 0) {
             return false;
         }
     }
     return true;
 }
 
-bool ArgParser::ValidateParam(const std::string& param) const {
+bool ArgParser::ValidateParam(std::string_view param) const {
     if (param == kNoneParamName) return false;
-    return !CheckType(ArgType::kNone, param);
+    return name_to_argument_node_.contains(param);
 }
 
 bool ArgParser::ValidateFlag(const char flag) const {
     if (flag == kNoneFlag) return false;
-    return flag_to_name_[flag] != kNoneParamName;
+    return flag_to_name_[static_cast<unsigned char>(flag)] != kNoneParamName;
 }
 
-void ArgParser::AddArgument(const char flag, 
-    const std::string& param_name, Node* arg_ptr)
+void ArgParser::AddArgument(const char flag, std::string_view param_name, Node* arg_ptr)
 {
     Update();
-    name_to_argument_node_[param_name] = 
-        std::unique_ptr<Node>(arg_ptr);
+    std::unique_ptr<Node>& node = name_to_argument_node_[param_name];
+    if (node != nullptr) {
+        std::erase(node_context_->touched, node.get());
+    }
+    node = std::unique_ptr<Node>(arg_ptr);
+    arg_ptr->Attach(node_context_.get(), next_node_id_++);
     if (flag != kNoneFlag) {
-        flag_to_name_[flag] = param_name;
+        flag_to_name_[static_cast<unsigned char>(flag)] = param_name;
     }
     need_update_ = true;
+    need_index_ = true;
+    need_suggest_index_ = true;
     last_added_param_ = param_name;
 }
 
-void ArgParser::ArgCalled(const std::string& param) {
+void ArgParser::ArgCalled(std::string_view param) {
+    if (trace_ != nullptr) {
+        trace_->ops.push_back(TraceOp{param, {}, true});
+        return;
+    }
     GetArg(param).ArgCalled();
 }
 
-void ArgParser::SetPositional(const std::string& param) {
+bool ArgParser::AddValueTo(std::string_view param, std::string_view val,
+    const std::pair<int, bool>* converted)
+{
+    if (trace_ != nullptr) {
+        trace_->ops.push_back(TraceOp{param, val, false});
+        return true;
+    }
+    Node& node = GetArg(param);
+    if (converted != nullptr && node.GetType() == ArgType::kIntArg) {
+        return static_cast<IntArg&>(node).AddConverted(*converted);
+    }
+    return node.AddValue(val);
+}
+
+void ArgParser::SetPositional(std::string_view param) {
     if (positional_param_ != kNoneParamName) {
         throw std::runtime_error("Positional argument could be only one");        
     }
     positional_param_ = param;
 }
 
-bool ArgParser::AddToPostional(const std::string& val) {
+bool ArgParser::AddToPostional(std::string_view val, const std::pair<int, bool>* converted) {
     Update();
     if (positional_param_ == kNoneParamName) {
         return false;
     }
+    return AddValueTo(positional_param_, val, converted);
+}
+
+int ArgParser::AddToPostional(const std::vector<std::string>& args, int first) {
+    if (first >= args.size()) {
+        return kNoIndex;
+    }
+    Update();
+    if (positional_param_ == kNoneParamName) {
+        return first;
+    }
+    if (trace_ != nullptr) {
+        for (int i = first; i < args.size(); ++i) {
+            AddValueTo(positional_param_, args[i]);
+        }
+        return kNoIndex;
+    }
     Node& node = GetArg(positional_param_);
-    return node.AddValue(val);
+    return node.AddValues(args, first);
+}
+
+int ArgParser::AddToPostional(const Prepass& prepass, int first) {
+    if (first >= prepass.ints.size()) {
+        return kNoIndex;
+    }
+    Update();
+    // The caller has checked that the positional argument is an IntArg
+    return static_cast<IntArg&>(GetArg(positional_param_)).AddConverted(prepass.ints, first);
+}
+
+int ArgParser::AddToPostional(const std::vector<std::string_view>& args, int first) {
+    int bad_ind = kNoIndex;
+    for (int i = first; i < args.size(); ++i) {
+        if (!AddToPostional(args[i]) && bad_ind == kNoIndex) {
+            bad_ind = i;
+        }
+    }
+    return bad_ind;
+}
+
+void ArgParser::SetParseError(ErrorCode code, int token_index) {
+    if (trace_ != nullptr) {
+        trace_->is_replayable = false;
+        return;
+    }
+    // Only the first error of a parse is kept
+    if (parse_error_.code == ErrorCode::kOk) {
+        parse_error_ = ParseError{code, token_index};
+    }
+}
+
+ErrorCode ArgParser::FindNode(const std::string& param, ArgType type,
+    const Node*& node) const
+{
+    auto it = name_to_argument_node_.find(param);
+    if (it == name_to_argument_node_.end()) {
+        return ErrorCode::kUnknownParam;
+    }
+    if (!CheckType(type, it->second)) {
+        return ErrorCode::kTypeMismatch;
+    }
+    node = it->second.get();
+    return ErrorCode::kOk;
 }
 
 void ArgParser::Update() {
@@ -214,14 +663,46 @@ void ArgParser::Update() {
 
 void ArgParser::Reset() {
     Update();
-    for (auto& [param, ptr] : name_to_argument_node_) {
-        ptr->Reset();
+    BuildIndex();
+    if (node_context_->requirements_changed) {
+        BuildRequiredMask();
+    }
+    for (Node* node : node_context_->touched) {
+        node->Reset();
+        node->ClearTouched();
     }
+    node_context_->touched.clear();
+    last_args_hash_.reset();
     good_parse_ = true;
+    selected_subcommand_ = kNoneParamName;
+    unknown_param_ = kNoneParamName;
+    parse_error_ = ParseError();
 }
 
-ArgParser::Node& ArgParser::GetArg(const std::string& param) {
-    return *name_to_argument_node_[param];
+void ArgParser::BuildRequiredMask() {
+    required_mask_.assign((next_node_id_ + 63) / 64, 0);
+    used_mask_.assign(required_mask_.size(), 0);
+    for (const auto& [param, ptr] : name_to_argument_node_) {
+        if (ptr->IsRequired()) {
+            required_mask_[ptr->GetId() / 64] |= 1ull << (ptr->GetId() % 64);
+        }
+    }
+    node_context_->requirements_changed = false;
+}
+
+void ArgParser::BuildIndex() {
+    if (!need_index_) return;
+    std::vector<std::string> names;
+    names.reserve(name_to_argument_node_.size());
+    for (const auto& [param, ptr] : name_to_argument_node_) {
+        names.emplace_back(param);
+    }
+    long_names_.Build(std::move(names));
+    need_index_ = false;
+}
+
+ArgParser::Node& ArgParser::GetArg(std::string_view param) {
+    return *name_to_argument_node_.find(param)->second;
 }
 
 ArgParser::HelpArg& ArgParser::GetHelpArg() {
@@ -245,6 +726,13 @@ ArgParser::StringArg& ArgParser::GetStringArg(const std::string& param) {
     return static_cast<StringArg&>(GetArg(param));
 }
 
+ArgParser::IntSetArg& ArgParser::GetIntSetArg(const std::string& param) {
+    if (!CheckType(ArgType::kIntSetArg, param)) {
+        throw std::runtime_error(param + " is not int set arg");
+    }
+    return static_cast<IntSetArg&>(GetArg(param));
+}
+
 ArgParser::BoolArg& ArgParser::GetBoolArg(const std::string& param) {
     if (!CheckType(ArgType::kBoolArg, param)) {
         throw std::runtime_error(param + " is not bool arg");
@@ -252,16 +740,4 @@ ArgParser::BoolArg& ArgParser::GetBoolArg(const std::string& param) {
     return static_cast<BoolArg&>(GetArg(param));
 }
 
-std::string ArgParser::GetArgInfo(const Node& val, const std::string& name) {
-    std::string ret = kNullString;
-    ret = val.GetFlag() + "  " + 
-        val.GetLongArg(name) + "  " +
-        val.GetDescription() + "  ";
-    std::string reqs = val.GetRequirements();
-    if (reqs != kNullString) {
-        ret += "[" + reqs + "]";
-    }
-    return ret;
-}
-
 } // namespace ArgumentParser
\ No newline at end of file
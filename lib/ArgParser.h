@@ -1,28 +1,107 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <functional>
 #include <numeric>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <regex>
 
 #include <iostream>
 
+#include "BkTree.h"
+#include "FrozenSet.h"
+#include "IntSet.h"
+#include "MemoryReport.h"
+#include "PrefixIndex.h"
+#include "ResultCache.h"
+#include "Literal.h"
+#include "Tokenizer.h"
+
 namespace ArgumentParser {
 
+enum class CompletionShell {
+    kBash = 0,
+    kZsh
+};
+
+enum class ErrorCode : std::uint8_t {
+    kOk = 0,
+    kUnknownArgument,
+    kInvalidValue,
+    kNoPositional,
+    kMissingArgument,
+    kUnknownParam,
+    kTypeMismatch,
+    kNotInitialized,
+    kIndexOutOfRange,
+    kInvalidCommandLine,
+    kInvalidUtf8,
+    kAmbiguousArgument,
+    kInvalidSchema
+};
+
+std::string_view ToString(ErrorCode code);
+
+// token_index points into the parsed vector, -1 if the error is not
+// caused by a single token (e.g. a missing required argument)
+struct ParseError {
+    ErrorCode code = ErrorCode::kOk;
+    int token_index = -1;
+};
+
+// Filled by Parse(args, stats); counters are added to, so one object can
+// accumulate several parses. long_tokens counts tokens too long for the
+// small string buffer, i.e. the ones a std::string copy would allocate
+// for. tokenize_time and dispatch_time are sampled on one token in
+// kTimingSample and scaled up; the other phases are timed in full.
+struct ParseStats {
+    constexpr static std::uint32_t kTimingSample = 16;
+
+    std::uint64_t value_tokens = 0;
+    std::uint64_t flag_tokens = 0;
+    std::uint64_t argument_tokens = 0;
+    std::uint64_t unknown_tokens = 0;
+    std::uint64_t empty_tokens = 0;
+    std::uint64_t end_of_options_tokens = 0;
+    std::uint64_t name_lookups = 0;
+    std::uint64_t values_dispatched = 0;
+    std::uint64_t long_tokens = 0;
+    std::uint64_t token_bytes = 0;
+    std::chrono::nanoseconds reset_time{0};
+    std::chrono::nanoseconds tokenize_time{0};
+    std::chrono::nanoseconds dispatch_time{0};
+    std::chrono::nanoseconds validate_time{0};
+};
+
 class ArgParser {
     const static int kMaxFlagValue = 256;
     const static char kNoneFlag = '\0';
     const static int kMinSizeDefault = 1;
+    const static int kMaxSuggestDistance = 2;
+    const static int kMaxSuggestions = 3;
+    const static size_t kDefaultTopConsumers = 5;
+    const static int kNoIndex = -1;
+    constexpr static int kDefaultHelpWidth = 80;
+    constexpr static int kMinHelpTextWidth = 20;
     const static std::string kNullString;
     const static std::string kNoneParamName;
     const static std::string kDefaultHelpDescription;
+    const static std::string kEndOfOptions;
 private:
     enum class ArgType {
         kIntArg = 0,
         kBoolArg,
         kStringArg,
         kHelp,
+        kIntSetArg,
         kNone
     };
 
@@ -30,31 +109,93 @@ private:
         kValue = 0,
         kFlag,
         kArgument,
+        kUnknownArgument,
         kEmpty
     };
 
+    // Views point into the parsed args and into the keys of
+    // name_to_argument_node_, so the parse loop copies no strings
     struct ParseData {
-        std::string cur_param_name;
+        std::string_view cur_param_name;
         bool cur_param_got_arg;
-        std::string cur_parse_arg;
+        std::string_view cur_parse_arg;
         ParseArgType cur_type;
         int next_ind;
-        ParseData(const std::string& cur_param_name = kNoneParamName, 
+        // ConvertToInt result of cur_parse_arg from the parallel pre-pass,
+        // set only while cur_parse_arg is a whole token
+        const std::pair<int, bool>* cur_converted = nullptr;
+        ParseData(std::string_view cur_param_name = kNoneParamName, 
             const bool cur_param_got_arg = false);
     };
 
+    // Lets the name maps be searched by std::string_view without
+    // building a std::string key
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view val) const
+            { return std::hash<std::string_view>{}(val); }
+    };
+
+    template <typename T>
+    using NameMap = std::unordered_map<std::string, T, NameHash, std::equal_to<>>;
+
+    // Keys are views of string literals or of owned_strings_
+    template <typename T>
+    using ViewMap = std::unordered_map<std::string_view, T, NameHash, std::equal_to<>>;
+
+public:
+    using SubcommandFactory = std::function<void(ArgParser&)>;
+
+private:
+    struct Subcommand {
+        SubcommandFactory factory;
+        std::string description;
+        std::unique_ptr<ArgParser> parser;
+    };
+
+    class Node;
+
+    // Shared by the parser and its nodes: nodes register themselves in
+    // touched once their state differs from the reset one, so Reset and
+    // validation visit only them.
+    struct NodeContext {
+        std::vector<Node*> touched;
+        bool requirements_changed = true;
+        bool help_changed = true;
+        // Bumped by every change that can alter what a parse produces
+        std::uint64_t schema_version = 0;
+    };
+
+    // What a parse left in one node, see Node::SaveState. Single values
+    // are kept as one-element lists.
+    struct NodeState {
+        Node* node = nullptr;
+        bool is_used = false;
+        ErrorCode reject_code = ErrorCode::kOk;
+        int value_count = 0;
+        std::vector<int> ints;
+        std::vector<std::string> strings;
+        IntSet set;
+    };
+
     class Node {
      protected:
-        Node(const std::string& description, const char flag);
+        Node(std::string_view description, const char flag);
      public:
+        virtual ~Node() = default;
         virtual void Reset() { is_used_ = false; }
         virtual ArgType GetType() const { return ArgType::kNone; }
-        virtual bool AddValue(const std::string& val)
+        virtual bool AddValue(std::string_view val)
             {return true;}
+        // Adds args[first..] as values of one argument, returns the index
+        // of the first rejected one or kNoIndex
+        virtual int AddValues(const std::vector<std::string>& args, int first);
         virtual void ArgCalled() {}
+        // Why the first value since Reset was rejected by AddValue
+        virtual ErrorCode GetRejectCode() const { return ErrorCode::kInvalidValue; }
         virtual bool IsOk() const { return true; }
         virtual bool TakesArgument() const;
-        virtual std::string GetDescription() const { return description_; }
+        virtual std::string GetDescription() const { return std::string(description_); }
         virtual std::string GetFlag() const;
         virtual std::string GetLongArg(const std::string& name_) const
             { return "--" + name_; }
@@ -62,30 +203,59 @@ private:
             { return kNullString; }
         bool IsUsed() const { return is_used_; }
         bool IsMultiValue() const { return is_multivalue_; }
+        bool HasDefault() const { return has_default_; }
+        char GetFlagChar() const { return flag_; }
+        virtual bool IsRequired() const { return false; }
+        // Values are checked beyond their type (Range, Choices, Pattern,
+        // ValidateUtf8)
+        virtual bool HasValidators() const { return false; }
+        void Attach(NodeContext* context, int id);
+        int GetId() const { return id_; }
+        void ClearTouched() { is_touched_ = false; }
+        // Heap bytes of the node with its settings, and of the values it
+        // owns (storage given with StoreValue(s) belongs to the caller)
+        virtual size_t SchemaBytes() const { return sizeof(Node); }
+        virtual size_t ValueBytes() const { return 0; }
+        // Copy the values added since the last Reset out of the node and
+        // back; RestoreState expects a node in the reset state
+        virtual void SaveState(NodeState& state) const { state.is_used = is_used_; }
+        virtual void RestoreState(const NodeState& state);
      protected:
         void AddSepIfNotNull(std::string& val, const std::string& sep) const;
         virtual void CreateValuesIfNeed() {}
+        void Touch();
+        void RequirementsChanged();
+        NodeContext* context_ = nullptr;
+        int id_ = 0;
+        bool is_touched_ = false;
         bool is_used_ = false;
         bool has_default_ = false;
+        // Set once the value (values) pointer refers to user storage,
+        // which the node must not delete
         bool stores_value_ = false;
+        bool stores_values_ = false;
         bool is_multivalue_ = false;
-        std::string description_ = kNullString;
+        std::string_view description_;
         char flag_ = kNoneFlag;
     };
 
     class BoolArg : public Node {
      public:
-        BoolArg(const std::string& description, const char flag);
+        BoolArg(std::string_view description, const char flag);
         ~BoolArg();
         virtual void Reset() override;
         virtual ArgType GetType() const override { return ArgType::kBoolArg; }
-        virtual bool AddValue(const std::string& val) override;
+        virtual bool AddValue(std::string_view val) override;
         virtual void ArgCalled() override;
         virtual bool IsOk() const override;
         virtual std::string GetRequirements(std::string sep = ", ") const override;
+        virtual size_t SchemaBytes() const override { return sizeof(BoolArg); }
+        virtual size_t ValueBytes() const override;
+        virtual void RestoreState(const NodeState& state) override;
         BoolArg& Default(bool val);
         BoolArg& StoreValue(bool& storage);
         bool GetValue() const;
+        bool GetDefault() const { return default_val_; }
      protected:
         virtual void CreateValuesIfNeed() override;
      private:
@@ -95,12 +265,13 @@ private:
 
     class HelpArg : public Node {
      public:
-        HelpArg(const std::string& description, const char flag);
+        HelpArg(std::string_view description, const char flag);
         virtual void Reset() override;
         virtual ArgType GetType() const override { return ArgType::kHelp; }
-        virtual bool AddValue(const std::string& val) override;
+        virtual bool AddValue(std::string_view val) override;
         virtual void ArgCalled() override;
         virtual bool IsOk() const override;
+        virtual size_t SchemaBytes() const override { return sizeof(HelpArg); }
     protected:
         virtual void CreateValuesIfNeed() override {}
     };
@@ -110,9 +281,11 @@ private:
         virtual PositionalNode& Positional();
         virtual PositionalNode& MultiValue(int min_size = kMinSizeDefault);
         bool IsPositional() const { return is_positional_; }
+        int GetMinSize() const { return min_size_; }
+        virtual bool IsRequired() const override;
         virtual std::string GetRequirements(std::string sep = ", ") const override;
      protected:
-        PositionalNode(const std::string& description, const char flag) 
+        PositionalNode(std::string_view description, const char flag) 
         : Node(description, flag) {}
         bool is_positional_ = false;
         int min_size_ = kMinSizeDefault;
@@ -120,70 +293,184 @@ private:
 
     class IntArg : public PositionalNode {
      public:
-        IntArg(const std::string& description, const char flag);
+        IntArg(std::string_view description, const char flag);
         ~IntArg();
         virtual void Reset() override;
         virtual ArgType GetType() const override { return ArgType::kIntArg; }
-        virtual bool AddValue(const std::string& val) override;
+        virtual bool AddValue(std::string_view val) override;
+        virtual int AddValues(const std::vector<std::string>& args, int first) override;
+        // AddValue and AddValues for tokens that were already run through
+        // ConvertToInt, e.g. by the parallel pre-pass
+        bool AddConverted(std::pair<int, bool> converted);
+        int AddConverted(const std::vector<std::pair<int, bool>>& converted, int first);
         virtual bool IsOk() const override;
         virtual bool TakesArgument() const override { return true; }
         virtual std::string GetRequirements(std::string sep = ", ") const override;
         virtual std::string GetLongArg(const std::string& name) const override; 
         virtual IntArg& Positional() override;
         virtual IntArg& MultiValue(int min_size = kMinSizeDefault) override;
+        virtual size_t SchemaBytes() const override { return sizeof(IntArg); }
+        virtual bool HasValidators() const override { return has_range_; }
+        virtual size_t ValueBytes() const override;
+        virtual void SaveState(NodeState& state) const override;
+        virtual void RestoreState(const NodeState& state) override;
         virtual IntArg& StoreValue(int& storage);
         IntArg& StoreValues(std::vector<int>& storage);
         IntArg& Default(int val);
+        // Values outside [lo, hi] are rejected as invalid
+        IntArg& Range(int lo, int hi);
         int GetIntValue(int ind = 0) const;
+        std::expected<int, ErrorCode> TryGetIntValue(int ind = 0) const;
+        bool IsInitialized() const { return is_used_ || has_default_; }
+        size_t GetValueCount() const { return IsMultiValue() ? values_->size() : 1; }
+        int GetDefault() const { return default_val_; }
      protected:
         virtual void CreateValuesIfNeed() override;
      private:
+        bool InRange(int val) const;
+        bool AllInRange(const int* first, const int* last) const;
+
         int default_val_ = 0;
         int* stored_value_ = nullptr;
         std::vector<int>* values_ = nullptr;
+        bool has_range_ = false;
+        int range_lo_ = 0;
+        int range_hi_ = 0;
     };
 
 
     class StringArg : public PositionalNode {
      public:
-        StringArg(const std::string& description, const char flag);
+        StringArg(std::string_view description, const char flag);
         ~StringArg();
         virtual void Reset() override;
         virtual ArgType GetType() const override { return ArgType::kStringArg; }
-        virtual bool AddValue(const std::string& val) override;
+        virtual bool AddValue(std::string_view val) override;
+        virtual int AddValues(const std::vector<std::string>& args, int first) override;
+        virtual ErrorCode GetRejectCode() const override { return reject_code_; }
         virtual bool IsOk() const override;
         virtual bool TakesArgument() const override { return true; }
         virtual std::string GetRequirements(std::string sep = ", ") const override;
         virtual std::string GetLongArg(const std::string& name) const override; 
         virtual StringArg& Positional() override;
         virtual StringArg& MultiValue(int min_size = kMinSizeDefault) override;
+        virtual size_t SchemaBytes() const override;
+        virtual bool HasValidators() const override {
+            return !choices_.Empty() || pattern_ != nullptr || validate_utf8_;
+        }
+        virtual size_t ValueBytes() const override;
+        virtual void SaveState(NodeState& state) const override;
+        virtual void RestoreState(const NodeState& state) override;
         StringArg& StoreValue(std::string& storage);
         StringArg& StoreValues(std::vector<std::string>& storage);
         StringArg& Default(const std::string& val);
+        // Only the listed values are accepted
+        StringArg& Choices(std::vector<std::string> choices);
+        // Only values matching the whole ECMAScript pattern are accepted
+        StringArg& Pattern(const std::string& pattern);
+        // Values that are not well-formed UTF-8 are rejected with kInvalidUtf8
+        StringArg& ValidateUtf8();
         std::string GetStringValue(int ind = 0) const;
+        std::expected<std::string_view, ErrorCode> TryGetStringValue(int ind = 0) const;
+        bool IsInitialized() const { return is_used_ || has_default_; }
+        size_t GetValueCount() const { return IsMultiValue() ? values_->size() : 1; }
+        const std::string& GetDefault() const { return default_val_; }
     protected:
         virtual void CreateValuesIfNeed() override;
      private:
+        ErrorCode Check(std::string_view val) const;
+
         std::string default_val_ = kNullString;
         std::string* stored_value_ = nullptr;
         std::vector<std::string>* values_ = nullptr;
+        FrozenSet choices_;
+        std::string pattern_source_;
+        std::unique_ptr<std::regex> pattern_;
+        bool validate_utf8_ = false;
+        ErrorCode reject_code_ = ErrorCode::kOk;
+    };
+
+    // Set of ints written as values and inclusive ranges, e.g. "0-3,8,-2";
+    // every occurrence adds to the set
+    class IntSetArg : public PositionalNode {
+     public:
+        IntSetArg(std::string_view description, const char flag);
+        virtual void Reset() override;
+        virtual ArgType GetType() const override { return ArgType::kIntSetArg; }
+        virtual bool AddValue(std::string_view val) override;
+        virtual bool IsOk() const override;
+        virtual bool TakesArgument() const override { return true; }
+        virtual std::string GetRequirements(std::string sep = ", ") const override;
+        virtual std::string GetLongArg(const std::string& name) const override;
+        virtual IntSetArg& Positional() override;
+        virtual IntSetArg& MultiValue(int min_size = kMinSizeDefault) override;
+        virtual size_t SchemaBytes() const override;
+        virtual size_t ValueBytes() const override { return set_.HeapBytes(); }
+        virtual void SaveState(NodeState& state) const override;
+        virtual void RestoreState(const NodeState& state) override;
+        // Throws std::runtime_error if spec is not a valid set
+        IntSetArg& Default(const std::string& spec);
+        const IntSet& GetSet() const { return set_; }
+     private:
+        IntSet set_;
+        IntSet default_set_;
+        std::string default_spec_ = kNullString;
+        int value_count_ = 0;
     };
 
 public:
     ArgParser(const std::string& name);
     bool Parse(const int argc, char** argv);
     bool Parse(const std::vector<std::string>& args);
+    bool Parse(const std::vector<std::string>& args, ParseStats& stats);
+    // Splits a whole command line (program name first) with shell quoting
+    // rules, see CommandLineTokenizer. Not an overload of Parse, so that
+    // Parse({"app", "-a"}) is not ambiguous with the string_view
+    // iterator-pair constructor.
+    bool ParseCommandLine(std::string_view command_line);
+    // Moves the parser from the result of Parse(old_args) to the result
+    // of Parse(new_args) by replaying only the options whose tokens
+    // differ; their names are returned in changed. Falls back to a full
+    // Parse, with every option in changed, when the last parse was not
+    // Parse(old_args) (checked by a hash of the vector), when either vector
+    // selects a subcommand or has errors, or when the schema changed. The
+    // trace of new_args is kept, so chained calls trace one vector each.
+    bool Reparse(const std::vector<std::string>& old_args,
+        const std::vector<std::string>& new_args, std::vector<std::string>& changed);
     bool ProcessValue(ParseData& parse_data);
     bool ProcessFlag(ParseData& parse_data);
     bool ProcessArgument(ParseData& parse_data);
+    bool ProcessUnknownArgument(ParseData& parse_data);
     void AddHelp(const char flag, const std::string param_name, const std::string& description);
     bool Help();
     std::string HelpDescription();
+    // Help is rendered once per schema and then copied to the sink as is
+    std::string_view HelpText();
+    void WriteHelp(std::ostream& out);
+    bool WriteHelp(int fd);
+    void WriteHelp(const std::function<void(std::string_view)>& sink);
+    // Wrap width of the help text, by default the terminal width
+    void SetHelpWidth(int width);
 
     std::string GetStringValue(std::string param, int ind = 0);
     bool GetFlag(std::string param);
     int GetIntValue(std::string param, int ind = 0);
 
+    // Exception-free counterparts of Parse and the getters. Errors are
+    // plain codes; GetErrorMessage() formats text only when asked. A
+    // schema that Parse would throw on (e.g. two positional arguments)
+    // fails with kInvalidSchema.
+    std::expected<void, ParseError> TryParse(const int argc, char** argv);
+    std::expected<void, ParseError> TryParse(const std::vector<std::string>& args);
+    const ParseError& GetParseError() const;
+    std::expected<int, ErrorCode> TryGetIntValue(const std::string& param, int ind = 0) const;
+    // The view stays valid until the next Parse
+    std::expected<std::string_view, ErrorCode> TryGetStringValue(const std::string& param,
+        int ind = 0) const;
+    std::expected<bool, ErrorCode> TryGetFlag(const std::string& param) const;
+    const IntSet& GetIntSet(const std::string& param);
+    std::expected<const IntSet*, ErrorCode> TryGetIntSet(const std::string& param) const;
+
     IntArg& AddIntArgument(const char flag, const std::string& param_name, 
         const std::string& description = "");
     IntArg& AddIntArgument(const std::string& param_name, const std::string& description = "");
@@ -192,49 +479,349 @@ public:
         const std::string& description = "");
     StringArg& AddStringArgument(const std::string& param_name, const std::string& description = "");
 
+    IntSetArg& AddIntSetArgument(const char flag, const std::string& param_name,
+        const std::string& description = "");
+    IntSetArg& AddIntSetArgument(const std::string& param_name,
+        const std::string& description = "");
+
     BoolArg& AddFlag(const char flag, const std::string& param_name, 
         const std::string& description = "");
     BoolArg& AddFlag(const std::string& param_name, const std::string& description = "");
 
-    std::string GetParamByFlag(const char flag) const;
+    // Overloads for text that outlives the parser, see Literal. The
+    // name and the description are stored as views instead of copies.
+    IntArg& AddIntArgument(const char flag, Literal param_name,
+        Literal description = Literal(""))
+    {
+        return RegisterInt(flag, param_name.View(), description.View());
+    }
+
+    IntArg& AddIntArgument(Literal param_name, Literal description = Literal("")) {
+        return RegisterInt(kNoneFlag, param_name.View(), description.View());
+    }
+
+    StringArg& AddStringArgument(const char flag, Literal param_name,
+        Literal description = Literal(""))
+    {
+        return RegisterString(flag, param_name.View(), description.View());
+    }
+
+    StringArg& AddStringArgument(Literal param_name,
+        Literal description = Literal(""))
+    {
+        return RegisterString(kNoneFlag, param_name.View(), description.View());
+    }
+
+    IntSetArg& AddIntSetArgument(const char flag, Literal param_name,
+        Literal description = Literal(""))
+    {
+        return RegisterIntSet(flag, param_name.View(), description.View());
+    }
+
+    IntSetArg& AddIntSetArgument(Literal param_name,
+        Literal description = Literal(""))
+    {
+        return RegisterIntSet(kNoneFlag, param_name.View(), description.View());
+    }
+
+    BoolArg& AddFlag(const char flag, Literal param_name,
+        Literal description = Literal(""))
+    {
+        return RegisterFlag(flag, param_name.View(), description.View());
+    }
+
+    BoolArg& AddFlag(Literal param_name, Literal description = Literal("")) {
+        return RegisterFlag(kNoneFlag, param_name.View(), description.View());
+    }
+
+    // Declares arguments against members of one target object:
+    //     auto bind = parser.Bind(options);
+    //     bind.Flag("sum", &Options::sum);
+    //     bind.Int("N", &Options::values).Positional();
+    // A std::vector member makes the argument MultiValue. This is only a
+    // shorter way to write AddXxx(...).StoreValue(options.member): values
+    // still go through the node's AddValue and its storage pointer.
+    template <typename T>
+    class Binder {
+     public:
+        Binder(ArgParser& parser, T& target) : parser_(parser), target_(target) {}
+
+        BoolArg& Flag(const char flag, const std::string& param_name, bool T::* member,
+            const std::string& description = "")
+        {
+            return parser_.AddFlag(flag, param_name, description).StoreValue(target_.*member);
+        }
+
+        BoolArg& Flag(const std::string& param_name, bool T::* member,
+            const std::string& description = "")
+        {
+            return Flag(kNoneFlag, param_name, member, description);
+        }
+
+        IntArg& Int(const char flag, const std::string& param_name, int T::* member,
+            const std::string& description = "")
+        {
+            return parser_.AddIntArgument(flag, param_name, description)
+                .StoreValue(target_.*member);
+        }
+
+        IntArg& Int(const char flag, const std::string& param_name,
+            std::vector<int> T::* member, const std::string& description = "")
+        {
+            return parser_.AddIntArgument(flag, param_name, description)
+                .MultiValue().StoreValues(target_.*member);
+        }
+
+        template <typename Member>
+        IntArg& Int(const std::string& param_name, Member T::* member,
+            const std::string& description = "")
+        {
+            return Int(kNoneFlag, param_name, member, description);
+        }
+
+        StringArg& String(const char flag, const std::string& param_name,
+            std::string T::* member, const std::string& description = "")
+        {
+            return parser_.AddStringArgument(flag, param_name, description)
+                .StoreValue(target_.*member);
+        }
+
+        StringArg& String(const char flag, const std::string& param_name,
+            std::vector<std::string> T::* member, const std::string& description = "")
+        {
+            return parser_.AddStringArgument(flag, param_name, description)
+                .MultiValue().StoreValues(target_.*member);
+        }
+
+        template <typename Member>
+        StringArg& String(const std::string& param_name, Member T::* member,
+            const std::string& description = "")
+        {
+            return String(kNoneFlag, param_name, member, description);
+        }
+
+     private:
+        ArgParser& parser_;
+        T& target_;
+    };
+
+    template <typename T>
+    Binder<T> Bind(T& target) {
+        return Binder<T>(*this, target);
+    }
+
+    std::string_view GetParamByFlag(const char flag) const;
+
+    // Sub-parsers are built by their factory only when the subcommand
+    // token is met during Parse (or when GetSubparser asks for it).
+    void AddSubcommand(const std::string& name, SubcommandFactory factory,
+        const std::string& description = "");
+    bool HasSubcommand() const;
+    const std::string& GetSubcommand() const;
+    ArgParser& GetSubparser(const std::string& name);
+
+    constexpr static size_t kDefaultParallelThreshold = 1 << 16;
+    // From this many tokens on, Parse classifies the tokens and converts
+    // the values on worker threads first; the sequential pass then only
+    // binds values to options. 0 turns the pre-pass off.
+    void SetParallelThreshold(size_t min_tokens);
+
+    // Remembers the node states left by the last capacity distinct
+    // argument vectors given to Parse(args); parsing one of them again
+    // copies the states back instead of tokenizing and converting. The
+    // least recently used vector is dropped first, and any schema change
+    // empties the cache. Parses that select a subcommand are not cached.
+    // 0 turns the cache off.
+    void EnableResultCache(size_t capacity);
+    const ResultCacheStats& GetResultCacheStats() const;
+
+    // Accept unambiguous prefixes of long names, e.g. --num for --number
+    void AllowAbbreviations(bool allow = true);
+    // Long arguments ("--name") starting with prefix, in sorted order
+    std::vector<std::string> Complete(const std::string& prefix);
+    // Completion candidates in the format expected by the shell
+    std::string CompletionOutput(const std::string& prefix, CompletionShell shell);
+
+    // Registered names close to name, best first
+    std::vector<std::string> SuggestParams(const std::string& name,
+        int max_distance = kMaxSuggestDistance);
+    // Diagnostic of the last Parse, empty if nothing was reported
+    std::string GetErrorMessage();
+
+    // Bytes held by the parser by category, with the top_count arguments
+    // using the most. Built subcommand parsers are added to the categories.
+    MemoryReport MemoryUsage(size_t top_count = kDefaultTopConsumers) const;
+
+    // Binary schema cache (see Schema.cpp). The blob holds only offsets,
+    // so it can be written to a file once and mapped back by later runs.
+    // Loading is allowed only into a parser without registered arguments.
+    // It still builds a node per argument, but copies the string table
+    // once instead of every name and description; argparser_bench
+    // compares it with registering the same arguments. SchemaHash and
+    // SerializeSchema throw std::runtime_error for what the blob cannot
+    // encode: IntSet arguments, validators, subcommands and anything past
+    // the 4 GiB its 32-bit offsets address.
+    std::uint64_t SchemaHash() const;
+    std::string SerializeSchema() const;
+    bool SaveSchema(const std::string& path) const;
+    bool LoadSchema(std::string_view blob, std::uint64_t expected_hash);
+    bool LoadSchemaFile(const std::string& path, std::uint64_t expected_hash);
+
+    // Flat image of the values of the last parse, read back by ParseResult
+    // (see SharedResult.h). ExportResult puts it into a sealed memfd that
+    // forked or exec'ed workers attach to instead of parsing again; the
+    // descriptor is inherited across exec. Returns -1 on failure.
+    // SerializeResult is empty, and ExportResult fails, when the image
+    // would not fit the 32-bit offsets of the format (4 GiB).
+    std::string SerializeResult() const;
+    int ExportResult() const;
 
 private:
+    struct NoStats;
+    class StatsCollector;
+
+    // What a parse would do to the nodes, recorded instead of applied:
+    // ArgCalled(param) for a call, AddValue(value) otherwise
+    struct TraceOp {
+        std::string_view param;
+        std::string_view value;
+        bool is_call;
+    };
+
+    struct ParseTrace {
+        std::vector<TraceOp> ops;
+        bool is_replayable = true;
+    };
+
+    // Trace of the new vector of the last Reparse. Values view into args,
+    // a copy owned by the parser, since the caller's vector may be gone by
+    // the next call.
+    struct KeptTrace {
+        std::vector<std::string> args;
+        ParseTrace trace;
+        std::uint64_t schema_version = 0;
+        bool is_valid = false;
+    };
+
+    // Token types and ConvertToInt results for a whole argument vector
+    struct Prepass {
+        std::vector<ParseArgType> types;
+        std::vector<std::pair<int, bool>> ints;
+    };
+
+    // Node states and outcome of one parse, replayed by a cache hit
+    struct CachedParse {
+        std::vector<NodeState> states;
+        bool result = false;
+        bool good_parse = false;
+        ParseError parse_error;
+        std::string unknown_param;
+    };
+
+    bool ParseCached(const std::vector<std::string>& args);
+    // Argument names in the order of the schema records
+    std::vector<std::string_view> SchemaOrder() const;
+    // Passes the records and the string table of the schema blob to sink
+    template <typename Sink>
+    void WriteSchema(const std::vector<std::string_view>& names, Sink& sink) const;
+    void TraceParse(const std::vector<std::string>& args, ParseTrace& trace);
+    bool AddValueTo(std::string_view param, std::string_view val,
+        const std::pair<int, bool>* converted = nullptr);
+    template <typename Args>
+    void RunPrepass(const Args& args, int first_ind);
+
+    bool ParseFrom(const std::vector<std::string>& args, int first_ind);
+    // Args is std::vector<std::string> or std::vector<std::string_view>
+    template <typename Args, typename Stats>
+    bool ParseWith(const Args& args, int first_ind, Stats& stats);
+    bool IsSubcommand(const ParseData& parse_data) const;
+    // The current option was given without its value yet, so the next
+    // token is that value whatever it looks like
+    bool AwaitsValue(const ParseData& parse_data) const;
     void AssertType(ArgType type, const std::string &param_name) const;
-    bool CheckType(ArgType type, const std::string &param_name) const;
+    bool CheckType(ArgType type, std::string_view param_name) const;
     bool CheckType(ArgType type, const std::unique_ptr<Node>& node) const;
-    bool CheckPositional(const std::string& param_name) const;
-    bool CheckAddNewArg(const char flag, const std::string& param_name) const;
+    bool CheckPositional(std::string_view param_name) const;
+    bool CheckAddNewArg(const char flag, std::string_view param_name) const;
     bool CheckArgsAreOk();
-    bool ValidateParam(const std::string& param) const;
+    bool ValidateParam(std::string_view param) const;
     bool ValidateFlag(const char flag) const;
-    void AddArgument(const char flag, const std::string& param_name, 
-        Node* arg_ptr);
-    void ArgCalled(const std::string& param);
-    void SetPositional(const std::string& param);
-    bool AddToPostional(const std::string& val);
+    void AddArgument(const char flag, std::string_view param_name, Node* arg_ptr);
+    // Views passed here are stored as is, see Intern
+    IntArg& RegisterInt(const char flag, std::string_view param_name,
+        std::string_view description);
+    StringArg& RegisterString(const char flag, std::string_view param_name,
+        std::string_view description);
+    BoolArg& RegisterFlag(const char flag, std::string_view param_name,
+        std::string_view description);
+    IntSetArg& RegisterIntSet(const char flag, std::string_view param_name,
+        std::string_view description);
+    // Copy of val owned by the parser, for names and descriptions that
+    // are not literals
+    std::string_view Intern(std::string_view val);
+    void ArgCalled(std::string_view param);
+    void SetPositional(std::string_view param);
+    bool AddToPostional(std::string_view val, const std::pair<int, bool>* converted = nullptr);
+    int AddToPostional(const std::vector<std::string>& args, int first);
+    int AddToPostional(const Prepass& prepass, int first);
+    int AddToPostional(const std::vector<std::string_view>& args, int first);
+    void SetParseError(ErrorCode code, int token_index);
+    ErrorCode FindNode(const std::string& param, ArgType type, const Node*& node) const;
     void Update();
     void Reset();
+    void BuildRequiredMask();
     // std::unique_ptr<Node> CreateNode(ArgType type);
-    Node& GetArg(const std::string& param);
+    Node& GetArg(std::string_view param);
     HelpArg& GetHelpArg();
     IntArg& GetIntArg(const std::string& param);
     StringArg& GetStringArg(const std::string& param);
+    IntSetArg& GetIntSetArg(const std::string& param);
     BoolArg& GetBoolArg(const std::string& param);
-    std::string GetArgInfo(const Node& val, const std::string& name);
+    void RenderHelp();
+    int GetHelpWidth() const;
 
-    ParseArgType GetParseArgType(const std::string& arg) const;
-    std::string GetParamByLongArg(const std::string& long_arg) const;
+    ParseArgType GetParseArgType(std::string_view arg) const;
+    std::string_view GetParamByLongArg(std::string_view long_arg) const;
+    std::string_view ResolveParam(std::string_view param) const;
+    void BuildIndex();
 
-    std::string positional_param_ = kNoneParamName;
-    std::string last_added_param_ = kNoneParamName;
+    std::string_view positional_param_ = kNoneParamName;
+    std::string_view last_added_param_ = kNoneParamName;
     std::string help_node_param_ = kNoneParamName;
     std::string program_description_ = kNullString;
+    std::string help_text_ = kNullString;
+    int help_width_ = 0;
     std::string name_;
     bool need_update_ = false;
     bool good_parse_ = true;
+    bool allow_abbreviations_ = false;
+    bool need_index_ = true;
+    bool need_suggest_index_ = true;
 
-    std::unordered_map<std::string, std::unique_ptr<Node>> name_to_argument_node_;
-    std::vector<std::string> flag_to_name_;
+    int next_node_id_ = 0;
+    std::string selected_subcommand_ = kNoneParamName;
+    std::string unknown_param_ = kNoneParamName;
+    ParseError parse_error_;
+    std::deque<std::string> owned_strings_;
+    ViewMap<std::unique_ptr<Node>> name_to_argument_node_;
+    NameMap<Subcommand> subcommands_;
+    PrefixIndex long_names_;
+    BkTree suggest_index_;
+    CommandLineTokenizer tokenizer_;
+    ParseTrace* trace_ = nullptr;
+    size_t parallel_threshold_ = kDefaultParallelThreshold;
+    Prepass prepass_;
+    ResultCache<CachedParse> result_cache_;
+    std::uint64_t cache_version_ = 0;
+    // HashArgs of the vector the nodes were last parsed from, empty after
+    // a Reset that no parse followed
+    std::optional<std::uint64_t> last_args_hash_;
+    KeptTrace kept_trace_;
+    std::vector<std::string> trace_args_;
+    std::vector<std::string_view> flag_to_name_;
+    std::unique_ptr<NodeContext> node_context_ = std::make_unique<NodeContext>();
+    std::vector<std::uint64_t> required_mask_;
+    std::vector<std::uint64_t> used_mask_;
 };
 
 } // namespace ArgumentParser
\ No newline at end of file
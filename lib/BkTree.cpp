@@ -0,0 +1,93 @@
+#include "BkTree.h"
+
+#include "MemoryReport.h"
+
+#include <algorithm>
+
+namespace ArgumentParser {
+
+int EditDistance(std::string_view lhs, std::string_view rhs) {
+    if (lhs.size() < rhs.size()) {
+        std::swap(lhs, rhs);
+    }
+    std::vector<int> row(rhs.size() + 1);
+    for (int j = 0; j < row.size(); ++j) {
+        row[j] = j;
+    }
+    for (int i = 1; i <= lhs.size(); ++i) {
+        int diagonal = row[0];
+        row[0] = i;
+        for (int j = 1; j <= rhs.size(); ++j) {
+            int replace = diagonal + (lhs[i - 1] != rhs[j - 1]);
+            diagonal = row[j];
+            row[j] = std::min({row[j] + 1, row[j - 1] + 1, replace});
+        }
+    }
+    return row[rhs.size()];
+}
+
+void BkTree::Build(const std::vector<std::string>& words) {
+    nodes_.clear();
+    nodes_.reserve(words.size());
+    for (const std::string& word : words) {
+        Insert(word);
+    }
+}
+
+std::vector<std::pair<int, std::string>> BkTree::Find(std::string_view word,
+    int max_distance) const
+{
+    std::vector<std::pair<int, std::string>> ret;
+    if (nodes_.empty()) {
+        return ret;
+    }
+    std::vector<int> stack = {0};
+    while (!stack.empty()) {
+        const Node& node = nodes_[stack.back()];
+        stack.pop_back();
+        int distance = EditDistance(word, node.word);
+        if (distance <= max_distance) {
+            ret.emplace_back(distance, node.word);
+        }
+        for (const auto& [edge, child] : node.children) {
+            if (edge >= distance - max_distance && edge <= distance + max_distance) {
+                stack.push_back(child);
+            }
+        }
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+}
+
+void BkTree::Insert(const std::string& word) {
+    if (nodes_.empty()) {
+        nodes_.push_back(Node{word, {}});
+        return;
+    }
+    int cur = 0;
+    while (true) {
+        int distance = EditDistance(word, nodes_[cur].word);
+        if (distance == 0) {
+            return;
+        }
+        auto& children = nodes_[cur].children;
+        auto it = std::find_if(children.begin(), children.end(),
+            [distance](const std::pair<int, int>& child) { return child.first == distance; });
+        if (it == children.end()) {
+            children.emplace_back(distance, nodes_.size());
+            nodes_.push_back(Node{word, {}});
+            return;
+        }
+        cur = it->second;
+    }
+}
+
+size_t BkTree::HeapBytes() const {
+    size_t bytes = VectorBytes(nodes_);
+    for (const Node& node : nodes_) {
+        bytes += StringBytes(node.word) + VectorBytes(node.children);
+    }
+    return bytes;
+}
+
+} // namespace ArgumentParser
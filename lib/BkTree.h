@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ArgumentParser {
+
+int EditDistance(std::string_view lhs, std::string_view rhs);
+
+// Burkhard-Keller tree over argument names. The triangle inequality of
+// the edit distance lets a lookup skip every subtree whose edge distance
+// differs from the query distance by more than max_distance.
+class BkTree {
+ public:
+    void Build(const std::vector<std::string>& words);
+    // Words within max_distance of word, closest (then alphabetical) first
+    std::vector<std::pair<int, std::string>> Find(std::string_view word,
+        int max_distance) const;
+    bool Empty() const { return nodes_.empty(); }
+    size_t HeapBytes() const;
+
+ private:
+    struct Node {
+        std::string word;
+        std::vector<std::pair<int, int>> children; // (distance, node index)
+    };
+
+    void Insert(const std::string& word);
+
+    std::vector<Node> nodes_;
+};
+
+} // namespace ArgumentParser
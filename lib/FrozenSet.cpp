@@ -0,0 +1,88 @@
+#include "FrozenSet.h"
+
+#include "MemoryReport.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace ArgumentParser {
+
+namespace {
+
+const std::uint64_t kMaxSeed = 256;
+// Table sizes tried are 2x, 4x and 8x the key count
+const int kMaxGrowth = 3;
+
+} // namespace
+
+void FrozenSet::Build(std::vector<std::string> keys) {
+    keys_.clear();
+    for (std::string& key : keys) {
+        if (std::find(keys_.begin(), keys_.end(), key) == keys_.end()) {
+            keys_.push_back(std::move(key));
+        }
+    }
+    size_t size = std::bit_ceil(std::max<size_t>(keys_.size() * 2, 2));
+    for (int growth = 0; growth < kMaxGrowth; ++growth, size *= 2) {
+        slots_.assign(size, kNoSlot);
+        for (seed_ = 0; seed_ < kMaxSeed; ++seed_) {
+            if (TryPlace()) {
+                return;
+            }
+        }
+    }
+    seed_ = 0;
+    std::fill(slots_.begin(), slots_.end(), kNoSlot);
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        size_t slot = Slot(keys_[i]);
+        while (slots_[slot] != kNoSlot) {
+            slot = (slot + 1) & (slots_.size() - 1);
+        }
+        slots_[slot] = i;
+    }
+}
+
+bool FrozenSet::Contains(std::string_view key) const {
+    if (keys_.empty()) {
+        return false;
+    }
+    size_t slot = Slot(key);
+    while (slots_[slot] != kNoSlot) {
+        if (keys_[slots_[slot]] == key) {
+            return true;
+        }
+        slot = (slot + 1) & (slots_.size() - 1);
+    }
+    return false;
+}
+
+size_t FrozenSet::Slot(std::string_view key) const {
+    std::uint64_t hash = 14695981039346656037ull ^ seed_;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return (hash ^ (hash >> 32)) & (slots_.size() - 1);
+}
+
+bool FrozenSet::TryPlace() {
+    std::fill(slots_.begin(), slots_.end(), kNoSlot);
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        size_t slot = Slot(keys_[i]);
+        if (slots_[slot] != kNoSlot) {
+            return false;
+        }
+        slots_[slot] = i;
+    }
+    return true;
+}
+
+size_t FrozenSet::HeapBytes() const {
+    size_t bytes = VectorBytes(keys_) + VectorBytes(slots_);
+    for (const std::string& key : keys_) {
+        bytes += StringBytes(key);
+    }
+    return bytes;
+}
+
+} // namespace ArgumentParser
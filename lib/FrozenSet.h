@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ArgumentParser {
+
+// Immutable set of strings built once. Build looks for a hash seed that
+// gives every key its own slot, so Contains is one hash and one compare;
+// if no seed is found the table falls back to linear probing.
+class FrozenSet {
+ public:
+    void Build(std::vector<std::string> keys);
+    bool Contains(std::string_view key) const;
+    // Keys in the order given to Build, duplicates removed
+    const std::vector<std::string>& Keys() const { return keys_; }
+    bool Empty() const { return keys_.empty(); }
+    size_t HeapBytes() const;
+
+ private:
+    constexpr static std::uint32_t kNoSlot = UINT32_MAX;
+
+    size_t Slot(std::string_view key) const;
+    bool TryPlace();
+
+    std::vector<std::string> keys_;
+    std::vector<std::uint32_t> slots_;
+    std::uint64_t seed_ = 0;
+};
+
+} // namespace ArgumentParser
@@ -0,0 +1,169 @@
+#include "ArgParser.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace ArgumentParser {
+
+namespace {
+
+struct HelpRow {
+    std::string flag;
+    std::string long_arg;
+    std::string text;
+};
+
+// Appends text word by word, starting a new line indented by indent
+// whenever the next word does not fit into available columns
+void AppendWrapped(std::string& out, std::string_view text, int indent, int available) {
+    int line_size = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find(' ', pos);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        std::string_view word = text.substr(pos, end - pos);
+        pos = end + 1;
+        if (word.empty()) {
+            continue;
+        }
+        if (line_size != 0 && line_size + 1 + word.size() > available) {
+            out += '\n';
+            out.append(indent, ' ');
+            line_size = 0;
+        } else if (line_size != 0) {
+            out += ' ';
+            ++line_size;
+        }
+        out += word;
+        line_size += word.size();
+    }
+    out += '\n';
+}
+
+} // namespace
+
+std::string ArgParser::HelpDescription() {
+    return std::string(HelpText());
+}
+
+std::string_view ArgParser::HelpText() {
+    if (node_context_->help_changed) {
+        RenderHelp();
+    }
+    return help_text_;
+}
+
+void ArgParser::WriteHelp(std::ostream& out) {
+    std::string_view text = HelpText();
+    out.write(text.data(), text.size());
+}
+
+bool ArgParser::WriteHelp(int fd) {
+    std::string_view text = HelpText();
+    while (!text.empty()) {
+        ssize_t written = write(fd, text.data(), text.size());
+        // A signal that arrives before anything is written is not an error
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0) {
+            return false;
+        }
+        text.remove_prefix(written);
+    }
+    return true;
+}
+
+void ArgParser::WriteHelp(const std::function<void(std::string_view)>& sink) {
+    sink(HelpText());
+}
+
+void ArgParser::SetHelpWidth(int width) {
+    help_width_ = width;
+    node_context_->help_changed = true;
+}
+
+int ArgParser::GetHelpWidth() const {
+    if (help_width_ > 0) {
+        return help_width_;
+    }
+    winsize size;
+    if (isatty(STDOUT_FILENO) && ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0) {
+        return size.ws_col;
+    }
+    if (const char* columns = std::getenv("COLUMNS")) {
+        int width = std::atoi(columns);
+        if (width > 0) {
+            return width;
+        }
+    }
+    return kDefaultHelpWidth;
+}
+
+void ArgParser::RenderHelp() {
+    // Arguments go in registration order, help is the last one
+    std::vector<std::pair<int, std::string_view>> params;
+    params.reserve(name_to_argument_node_.size());
+    for (const auto& [param, ptr] : name_to_argument_node_) {
+        if (param != help_node_param_) {
+            params.emplace_back(ptr->GetId(), param);
+        }
+    }
+    std::sort(params.begin(), params.end());
+    if (help_node_param_ != kNoneParamName) {
+        params.emplace_back(0, help_node_param_);
+    }
+
+    std::vector<HelpRow> rows;
+    rows.reserve(params.size() + subcommands_.size());
+    size_t long_width = 0;
+    for (const auto& [id, param] : params) {
+        const Node& node = *name_to_argument_node_.find(param)->second;
+        HelpRow row{node.GetFlag(), node.GetLongArg(std::string(param)), node.GetDescription()};
+        std::string reqs = node.GetRequirements();
+        if (reqs != kNullString) {
+            row.text += (row.text.empty() ? "[" : " [") + reqs + "]";
+        }
+        long_width = std::max(long_width, row.long_arg.size());
+        rows.push_back(std::move(row));
+    }
+    std::vector<const std::string*> subcommand_names;
+    for (const auto& [name, subcommand] : subcommands_) {
+        subcommand_names.push_back(&name);
+    }
+    std::sort(subcommand_names.begin(), subcommand_names.end(),
+        [](const std::string* lhs, const std::string* rhs) { return *lhs < *rhs; });
+    // The help row stays last, after the subcommands
+    auto subcommand_pos = rows.end() - (help_node_param_ != kNoneParamName ? 1 : 0);
+    std::vector<HelpRow> subcommand_rows;
+    for (const std::string* name : subcommand_names) {
+        subcommand_rows.push_back(HelpRow{"  ", *name,
+            subcommands_.at(*name).description + " [subcommand]"});
+        long_width = std::max(long_width, name->size());
+    }
+    rows.insert(subcommand_pos, subcommand_rows.begin(), subcommand_rows.end());
+
+    int width = GetHelpWidth();
+    int indent = 2 + 2 + long_width + 2;
+    help_text_ = "Parser name: " + name_ + "\n";
+    if (program_description_ != kNullString) {
+        AppendWrapped(help_text_, program_description_, 0, std::max(width, kMinHelpTextWidth));
+    }
+    help_text_ += '\n';
+    for (const HelpRow& row : rows) {
+        help_text_ += row.flag;
+        help_text_ += "  ";
+        help_text_ += row.long_arg;
+        help_text_.append(long_width - row.long_arg.size() + 2, ' ');
+        AppendWrapped(help_text_, row.text, indent, std::max(width - indent, kMinHelpTextWidth));
+    }
+    node_context_->help_changed = false;
+}
+
+} // namespace ArgumentParser
@@ -0,0 +1,177 @@
+#include "IntSet.h"
+
+#include "MemoryReport.h"
+
+#include <algorithm>
+
+namespace ArgumentParser {
+
+namespace {
+
+// A bitmap of up to this many bits is used whatever the value count
+const std::int64_t kMinDenseBits = 1 << 12;
+const std::int64_t kMaxBitsPerValue = 64;
+
+std::int64_t AlignDown(std::int64_t val) {
+    return val - ((val % 64) + 64) % 64;
+}
+
+} // namespace
+
+bool IntSet::Insert(int val) {
+    return is_dense_ ? InsertDense(val) : InsertSparse(val);
+}
+
+bool IntSet::Contains(int val) const {
+    if (is_dense_) {
+        std::int64_t bit = val - base_;
+        if (bit < 0 || bit >= static_cast<std::int64_t>(words_.size()) * 64) {
+            return false;
+        }
+        return (words_[bit / 64] >> (bit % 64)) & 1;
+    }
+    for (size_t slot = Slot(val); slots_[slot] != kEmptySlot;
+        slot = (slot + 1) & (slots_.size() - 1))
+    {
+        if (slots_[slot] == val) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void IntSet::Clear() {
+    is_dense_ = true;
+    size_ = 0;
+    words_.clear();
+    slots_.clear();
+    shift_ = 64;
+}
+
+std::vector<int> IntSet::Values() const {
+    std::vector<int> ret;
+    ret.reserve(size_);
+    if (is_dense_) {
+        ForEach([&ret](int val) { ret.push_back(val); });
+        return ret;
+    }
+    for (std::int64_t slot : slots_) {
+        if (slot != kEmptySlot) {
+            ret.push_back(static_cast<int>(slot));
+        }
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+}
+
+size_t IntSet::InsertRange(int lo, int hi) {
+    size_t added = 0;
+    if (!is_dense_ || !CoverDense(lo, hi, static_cast<std::int64_t>(hi) - lo + 1)) {
+        for (std::int64_t val = lo; val <= hi; ++val) {
+            added += InsertSparse(static_cast<int>(val));
+        }
+        return added;
+    }
+    std::int64_t first = lo - base_;
+    std::int64_t last = hi - base_;
+    for (std::int64_t word = first / 64; word <= last / 64; ++word) {
+        std::int64_t from = std::max(first, word * 64) - word * 64;
+        std::int64_t to = std::min(last, word * 64 + 63) - word * 64;
+        std::uint64_t mask = (~std::uint64_t(0) >> (63 - (to - from))) << from;
+        added += std::popcount(mask & ~words_[word]);
+        words_[word] |= mask;
+    }
+    size_ += added;
+    return added;
+}
+
+bool IntSet::CoverDense(std::int64_t lo, std::int64_t hi, size_t count) {
+    if (words_.empty()) {
+        base_ = AlignDown(lo);
+        words_.push_back(0);
+    }
+    std::int64_t end = base_ + static_cast<std::int64_t>(words_.size()) * 64;
+    if (lo >= base_ && hi < end) {
+        return true;
+    }
+    std::int64_t new_base = std::min(base_, AlignDown(lo));
+    std::int64_t new_end = std::max(end, AlignDown(hi) + 64);
+    if (new_end - new_base > std::max(kMinDenseBits,
+        kMaxBitsPerValue * static_cast<std::int64_t>(size_ + count)))
+    {
+        MakeSparse();
+        return false;
+    }
+    // Grows at both ends to the new bounds, keeping the old words
+    words_.insert(words_.begin(), (base_ - new_base) / 64, 0);
+    words_.resize((new_end - new_base) / 64, 0);
+    base_ = new_base;
+    return true;
+}
+
+bool IntSet::InsertDense(int val) {
+    if (!CoverDense(val, val, 1)) {
+        return InsertSparse(val);
+    }
+    std::int64_t bit = val - base_;
+    std::uint64_t mask = std::uint64_t(1) << (bit % 64);
+    if (words_[bit / 64] & mask) {
+        return false;
+    }
+    words_[bit / 64] |= mask;
+    ++size_;
+    return true;
+}
+
+bool IntSet::InsertSparse(int val) {
+    if ((size_ + 1) * 2 > slots_.size()) {
+        Rehash(std::max<size_t>(slots_.size() * 2, 16));
+    }
+    size_t slot = Slot(val);
+    for (; slots_[slot] != kEmptySlot; slot = (slot + 1) & (slots_.size() - 1)) {
+        if (slots_[slot] == val) {
+            return false;
+        }
+    }
+    slots_[slot] = val;
+    ++size_;
+    return true;
+}
+
+void IntSet::MakeSparse() {
+    std::vector<int> values = Values();
+    is_dense_ = false;
+    words_.clear();
+    size_ = 0;
+    Rehash(std::bit_ceil(std::max<size_t>(values.size() * 4, 16)));
+    for (int val : values) {
+        InsertSparse(val);
+    }
+}
+
+void IntSet::Rehash(size_t slot_count) {
+    std::vector<std::int64_t> old_slots = std::move(slots_);
+    slots_.assign(slot_count, kEmptySlot);
+    shift_ = 64 - std::countr_zero(slot_count);
+    for (std::int64_t slot : old_slots) {
+        if (slot != kEmptySlot) {
+            size_t pos = Slot(static_cast<int>(slot));
+            while (slots_[pos] != kEmptySlot) {
+                pos = (pos + 1) & (slots_.size() - 1);
+            }
+            slots_[pos] = slot;
+        }
+    }
+}
+
+size_t IntSet::Slot(int val) const {
+    // Fibonacci hashing: the top bits of the product are well mixed
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(val)) *
+        0x9E3779B97F4A7C15ull) >> shift_;
+}
+
+size_t IntSet::HeapBytes() const {
+    return VectorBytes(words_) + VectorBytes(slots_);
+}
+
+} // namespace ArgumentParser
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ArgumentParser {
+
+// Set of ints with O(1) Insert and Contains. Values close to each other
+// are kept in a bitmap; once the bitmap would take more than a word per
+// value the set moves to an open-addressing hash table.
+class IntSet {
+ public:
+    // Returns false if val was already in the set
+    bool Insert(int val);
+    // Inserts every value of [lo, hi] and returns how many were new. The
+    // bitmap is filled a word at a time.
+    size_t InsertRange(int lo, int hi);
+    bool Contains(int val) const;
+    size_t Size() const { return size_; }
+    bool Empty() const { return size_ == 0; }
+    bool IsDense() const { return is_dense_; }
+    size_t HeapBytes() const;
+    // Keeps the allocated memory for the next values
+    void Clear();
+    // Values in ascending order
+    std::vector<int> Values() const;
+
+    // Calls func(val) for every value in ascending order
+    template <typename Func>
+    void ForEach(Func func) const {
+        if (!is_dense_) {
+            for (int val : Values()) {
+                func(val);
+            }
+            return;
+        }
+        for (size_t i = 0; i < words_.size(); ++i) {
+            for (std::uint64_t word = words_[i]; word != 0; word &= word - 1) {
+                func(static_cast<int>(base_ + i * 64 + std::countr_zero(word)));
+            }
+        }
+    }
+
+    bool operator==(const IntSet& other) const { return Values() == other.Values(); }
+
+ private:
+    constexpr static std::int64_t kEmptySlot = INT64_MAX;
+
+    // Grows the bitmap to cover [lo, hi], which adds at most count values;
+    // moves to the hash table and returns false if it would get too sparse
+    bool CoverDense(std::int64_t lo, std::int64_t hi, size_t count);
+    bool InsertDense(int val);
+    bool InsertSparse(int val);
+    void MakeSparse();
+    void Rehash(size_t slot_count);
+    size_t Slot(int val) const;
+
+    bool is_dense_ = true;
+    size_t size_ = 0;
+    // Bit i stands for base_ + i
+    std::int64_t base_ = 0;
+    std::vector<std::uint64_t> words_;
+    // Linear probing over a power of two number of slots
+    std::vector<std::int64_t> slots_;
+    int shift_ = 64;
+};
+
+} // namespace ArgumentParser
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace ArgumentParser {
+
+// Text with static storage duration, e.g. a string literal. Add*Argument
+// and AddFlag keep it as a view instead of copying it:
+//     parser.AddFlag('a', Literal("all"), Literal("Every file"));
+// The constructor is consteval and explicit, so a local buffer does not
+// compile and plain literals still take the copying overloads.
+class Literal {
+ public:
+    template <size_t N>
+    explicit consteval Literal(const char (&str)[N]) : view_(str, N - 1) {}
+
+    constexpr std::string_view View() const { return view_; }
+
+ private:
+    std::string_view view_;
+};
+
+} // namespace ArgumentParser
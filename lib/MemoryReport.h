@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ArgumentParser {
+
+// Heap bytes held by a parser, returned by ArgParser::MemoryUsage. Sizes
+// come from string and container capacities; allocator overhead is not
+// included and hash map nodes are estimated.
+struct MemoryReport {
+    // Argument nodes with their settings and defaults, interned names
+    // and descriptions, the flag table and subcommand entries
+    size_t schema = 0;
+    // Name map, long name prefix index and suggestion tree
+    size_t name_index = 0;
+    // Rendered help and the program description
+    size_t help_text = 0;
+    // Values of the last parse that the nodes own (user storage is not
+    // counted)
+    size_t value_storage = 0;
+    // Scratch kept between parses: pre-pass results, tokenizer arena,
+    // touched list, required/used masks and the trace kept by Reparse
+    size_t parse_buffers = 0;
+    // Arguments holding the most schema plus value bytes, largest first
+    std::vector<std::pair<std::string, size_t>> top_arguments;
+
+    size_t Total() const {
+        return schema + name_index + help_text + value_storage + parse_buffers;
+    }
+};
+
+// Heap bytes behind a string; short strings live in the object itself
+inline size_t StringBytes(const std::string& str) {
+    return str.capacity() > std::string().capacity() ? str.capacity() + 1 : 0;
+}
+
+// Heap bytes of the vector buffer, not of what the elements point to
+template <typename T>
+size_t VectorBytes(const std::vector<T>& vec) {
+    return vec.capacity() * sizeof(T);
+}
+
+} // namespace ArgumentParser
@@ -1,33 +1,87 @@
 #include "ArgParser.h"
+#include "Utf8.h"
 
-std::pair<int, bool> ConvertToInt(const std::string& val) {
+#include <limits>
+
+std::pair<int, bool> ConvertToInt(std::string_view val) {
     int ret = 0;
     int k = 1;
     int ind = 0;
-    if (val[0] == '-') {
+    if (!val.empty() && val[0] == '-') {
         k = -1;
         ++ind;
     }
+    if (ind == val.size()) {
+        return {-1, false};
+    }
+    // Accumulated as a negative number, its range covers INT_MIN
+    const int limit = k == 1 ? -std::numeric_limits<int>::max() : std::numeric_limits<int>::min();
     while (ind < val.size()) {
-        if (!isdigit(val[ind])) {
+        if (!isdigit(static_cast<unsigned char>(val[ind]))) {
+            return {-1, false};
+        }
+        int digit = val[ind] - '0';
+        if (ret < (limit + digit) / 10) {
             return {-1, false};
         }
-        ret *= 10;
-        ret += val[ind] - '0';
+        ret = ret * 10 - digit;
         ++ind;
     }
-    return {ret * k, true};
+    return {k == 1 ? -ret : ret, true};
+}
+
+// Most values one int set value may stand for, all of its items together,
+// so that a short token cannot expand into an unbounded amount of work
+const std::int64_t kMaxIntSetValues = 1 << 20;
+
+// Calls func(lo, hi) for every item of a comma separated list of values
+// and inclusive ranges; returns false at the first malformed item or once
+// the items stand for more than kMaxIntSetValues values
+template <typename Func>
+bool ForEachIntSetItem(std::string_view spec, Func func) {
+    std::int64_t total = 0;
+    while (true) {
+        size_t comma = spec.find(',');
+        std::string_view item = spec.substr(0, comma);
+        // A leading '-' is the sign of the first bound
+        size_t dash = item.find('-', 1);
+        auto [lo, is_lo_ok] = ConvertToInt(item.substr(0, dash));
+        auto [hi, is_hi_ok] = dash == std::string_view::npos ?
+            std::pair<int, bool>(lo, is_lo_ok) : ConvertToInt(item.substr(dash + 1));
+        if (!is_lo_ok || !is_hi_ok || lo > hi) {
+            return false;
+        }
+        total += static_cast<std::int64_t>(hi) - lo + 1;
+        if (total > kMaxIntSetValues) {
+            return false;
+        }
+        func(lo, hi);
+        if (comma == std::string_view::npos) {
+            return true;
+        }
+        spec.remove_prefix(comma + 1);
+    }
 }
 
 namespace ArgumentParser {
     // Node //
-    ArgParser::Node::Node(const std::string& descrption, const char flag)
+    ArgParser::Node::Node(std::string_view descrption, const char flag)
         : description_(descrption), flag_(flag) {}
     
     bool ArgParser::Node::TakesArgument() const {
         return false;
     }
 
+    int ArgParser::Node::AddValues(const std::vector<std::string>& args, int first) {
+        int bad_ind = kNoIndex;
+        for (int i = first; i < args.size(); ++i) {
+            if (!AddValue(args[i]) && bad_ind == kNoIndex) {
+                bad_ind = i;
+            }
+        }
+        return bad_ind;
+    }
+
     std::string ArgParser::Node::GetFlag() const {
         std::string ret = "  ";
         if (flag_ != kNoneFlag) {
@@ -37,6 +91,33 @@ namespace ArgumentParser {
         return ret;
     }
 
+    void ArgParser::Node::Attach(NodeContext* context, int id) {
+        context_ = context;
+        id_ = id;
+        is_touched_ = false;
+        Touch();
+        RequirementsChanged();
+    }
+
+    void ArgParser::Node::Touch() {
+        if (is_touched_ || context_ == nullptr) return;
+        is_touched_ = true;
+        context_->touched.push_back(this);
+    }
+
+    void ArgParser::Node::RequirementsChanged() {
+        if (context_ != nullptr) {
+            context_->requirements_changed = true;
+            context_->help_changed = true;
+            ++context_->schema_version;
+        }
+    }
+
+    void ArgParser::Node::RestoreState(const NodeState& state) {
+        Touch();
+        is_used_ = state.is_used;
+    }
+
     void ArgParser::Node::AddSepIfNotNull(std::string& val, const std::string& sep) const {
         if (val != kNullString) {
             val += sep;
@@ -45,15 +126,14 @@ namespace ArgumentParser {
 
 
     // BoolArg //
-    ArgParser::BoolArg::BoolArg(const std::string& description, const char flag) :
+    ArgParser::BoolArg::BoolArg(std::string_view description, const char flag) :
         Node(description, flag)
     {
         stored_value_ = nullptr;
     }
 
     ArgParser::BoolArg::~BoolArg() {
-        if (!stores_value_) return;
-        if (stored_value_ != nullptr) {
+        if (!stores_value_) {
             delete stored_value_;
         }
     }
@@ -61,14 +141,16 @@ namespace ArgumentParser {
     void ArgParser::BoolArg::Reset() {
         Node::Reset();
         CreateValuesIfNeed();
+        *stored_value_ = default_val_;
     }
 
-    bool ArgParser::BoolArg::AddValue(const std::string& val) {
+    bool ArgParser::BoolArg::AddValue(std::string_view val) {
         ArgCalled();
         return true;
     }
 
     void ArgParser::BoolArg::ArgCalled() {
+        Touch();
         CreateValuesIfNeed();
         *stored_value_ = true;
         is_used_ = true;
@@ -83,6 +165,7 @@ namespace ArgumentParser {
     }
 
     ArgParser::BoolArg& ArgParser::BoolArg::Default(bool val) {
+        Touch();
         has_default_ = true;
         default_val_ = val;
         CreateValuesIfNeed();
@@ -90,7 +173,8 @@ namespace ArgumentParser {
     }
 
     ArgParser::BoolArg& ArgParser::BoolArg::StoreValue(bool& storage) {
-        if (stored_value_ != nullptr && !stores_value_) {
+        Touch();
+        if (!stores_value_) {
             delete stored_value_;
         }
         stored_value_ = &storage;
@@ -109,21 +193,32 @@ namespace ArgumentParser {
         }
     }
 
+    size_t ArgParser::BoolArg::ValueBytes() const {
+        return stored_value_ != nullptr && !stores_value_ ? sizeof(bool) : 0;
+    }
+
+    void ArgParser::BoolArg::RestoreState(const NodeState& state) {
+        if (state.is_used) {
+            ArgCalled();
+        }
+    }
+
 
     // HelpArg //
-    ArgParser::HelpArg::HelpArg(const std::string& description, const char flag) :
+    ArgParser::HelpArg::HelpArg(std::string_view description, const char flag) :
         Node(description, flag) {}
 
     void ArgParser::HelpArg::Reset() {
         Node::Reset();
     }
 
-    bool ArgParser::HelpArg::AddValue(const std::string& val) {
+    bool ArgParser::HelpArg::AddValue(std::string_view val) {
         ArgCalled();
         return true;
     }
 
     void ArgParser::HelpArg::ArgCalled() {
+        Touch();
         CreateValuesIfNeed();
         is_used_ = true;
     }
@@ -135,16 +230,24 @@ namespace ArgumentParser {
 
     // PositionalNode //
     ArgParser::PositionalNode& ArgParser::PositionalNode::Positional() {
+        RequirementsChanged();
         is_positional_ = true;
         return *this; 
     }
 
     ArgParser::PositionalNode& ArgParser::PositionalNode::MultiValue(int min_size) {
+        Touch();
+        RequirementsChanged();
         is_multivalue_ = true;
         min_size_ = min_size;
         return *this;
     }
 
+    bool ArgParser::PositionalNode::IsRequired() const {
+        if (has_default_) return false;
+        return !is_multivalue_ || min_size_ > 0;
+    }
+
     std::string ArgParser::PositionalNode::GetRequirements(std::string sep) const {
         std::string ret = Node::GetRequirements(sep);
         if (is_multivalue_) {
@@ -163,15 +266,14 @@ namespace ArgumentParser {
     }
     
     // IntArg //
-    ArgParser::IntArg::IntArg(const std::string& description, const char flag) :
+    ArgParser::IntArg::IntArg(std::string_view description, const char flag) :
         PositionalNode(description, flag) {}
 
     ArgParser::IntArg::~IntArg() {
-        if (stores_value_) return;
-        if (stored_value_ != nullptr) {
+        if (!stores_value_) {
             delete stored_value_;
         }
-        if (values_ != nullptr) {
+        if (!stores_values_) {
             delete values_;
         }
     }
@@ -186,11 +288,16 @@ namespace ArgumentParser {
         }
     }
 
-    bool ArgParser::IntArg::AddValue(const std::string& val) {
+    bool ArgParser::IntArg::AddValue(std::string_view val) {
+        return AddConverted(ConvertToInt(val));
+    }
+
+    bool ArgParser::IntArg::AddConverted(std::pair<int, bool> converted) {
+        Touch();
         CreateValuesIfNeed();
-        
-        auto [nval, is_ok] = ConvertToInt(val);
-        if (!is_ok) {
+
+        auto [nval, is_ok] = converted;
+        if (!is_ok || !InRange(nval)) {
             return false;
         }
         if (IsMultiValue()) {
@@ -202,6 +309,62 @@ namespace ArgumentParser {
         return true;
     }
 
+    int ArgParser::IntArg::AddValues(const std::vector<std::string>& args, int first) {
+        if (!IsMultiValue()) {
+            return Node::AddValues(args, first);
+        }
+        Touch();
+        CreateValuesIfNeed();
+        size_t old_size = values_->size();
+        bool was_used = is_used_;
+        values_->reserve(old_size + args.size() - first);
+        int bad_ind = kNoIndex;
+        for (int i = first; i < args.size(); ++i) {
+            auto [nval, is_converted] = ConvertToInt(args[i]);
+            if (is_converted) {
+                values_->push_back(nval);
+                is_used_ = true;
+            } else if (bad_ind == kNoIndex) {
+                bad_ind = i;
+            }
+        }
+        if (!has_range_ || AllInRange(values_->data() + old_size,
+                values_->data() + values_->size())) {
+            return bad_ind;
+        }
+        // Some value is out of range: redo the list one value at a time
+        // to drop the rejected values and find the first one
+        values_->resize(old_size);
+        is_used_ = was_used;
+        return Node::AddValues(args, first);
+    }
+
+    int ArgParser::IntArg::AddConverted(const std::vector<std::pair<int, bool>>& converted,
+        int first)
+    {
+        int bad_ind = kNoIndex;
+        if (!IsMultiValue() || has_range_) {
+            for (int i = first; i < converted.size(); ++i) {
+                if (!AddConverted(converted[i]) && bad_ind == kNoIndex) {
+                    bad_ind = i;
+                }
+            }
+            return bad_ind;
+        }
+        Touch();
+        CreateValuesIfNeed();
+        values_->reserve(values_->size() + converted.size() - first);
+        for (int i = first; i < converted.size(); ++i) {
+            if (converted[i].second) {
+                values_->push_back(converted[i].first);
+                is_used_ = true;
+            } else if (bad_ind == kNoIndex) {
+                bad_ind = i;
+            }
+        }
+        return bad_ind;
+    }
+
     bool ArgParser::IntArg::IsOk() const {
         if (has_default_) return true;
         if (IsMultiValue()) {
@@ -217,6 +380,10 @@ namespace ArgumentParser {
             AddSepIfNotNull(ret, sep);
             ret += "default = " + std::to_string(default_val_);
         }
+        if (has_range_) {
+            AddSepIfNotNull(ret, sep);
+            ret += "range = [" + std::to_string(range_lo_) + ", " + std::to_string(range_hi_) + "]";
+        }
         return ret;
     }
 
@@ -238,26 +405,41 @@ namespace ArgumentParser {
     }
 
     ArgParser::IntArg& ArgParser::IntArg::StoreValue(int& storage) {
-        if (stored_value_ != nullptr && !stores_value_) delete stored_value_;
+        Touch();
+        if (!stores_value_) delete stored_value_;
         stored_value_ = &storage;
         stores_value_ = true;
         return *this;
     }
 
     ArgParser::IntArg& ArgParser::IntArg::StoreValues(std::vector<int>& storage) {
-        if (values_ != nullptr) delete values_;
+        Touch();
+        if (!stores_values_) delete values_;
         values_ = &storage;
-        stores_value_ = true;
+        stores_values_ = true;
         return *this;
     }
 
     ArgParser::IntArg& ArgParser::IntArg::Default(int val) { 
+        Touch();
+        RequirementsChanged();
         has_default_ = true;
         default_val_ = val;
         CreateValuesIfNeed();
         return *this;
     }
 
+    ArgParser::IntArg& ArgParser::IntArg::Range(int lo, int hi) {
+        if (lo > hi) {
+            throw std::runtime_error("Range lower bound exceeds upper bound");
+        }
+        RequirementsChanged();
+        has_range_ = true;
+        range_lo_ = lo;
+        range_hi_ = hi;
+        return *this;
+    }
+
     int ArgParser::IntArg::GetIntValue(int ind) const {
         if (!is_used_ && !has_default_) {
             throw std::runtime_error("Int value is not initialized");
@@ -269,6 +451,35 @@ namespace ArgumentParser {
         }
     }
 
+    std::expected<int, ErrorCode> ArgParser::IntArg::TryGetIntValue(int ind) const {
+        if (!is_used_ && !has_default_) {
+            return std::unexpected(ErrorCode::kNotInitialized);
+        }
+        if (!IsMultiValue()) {
+            return *stored_value_;
+        }
+        if (ind < 0 || ind >= values_->size()) {
+            return std::unexpected(ErrorCode::kIndexOutOfRange);
+        }
+        return (*values_)[ind];
+    }
+
+    bool ArgParser::IntArg::InRange(int val) const {
+        return !has_range_ || (val >= range_lo_ && val <= range_hi_);
+    }
+
+    bool ArgParser::IntArg::AllInRange(const int* first, const int* last) const {
+        // One unsigned compare per value and no early exit, so the loop
+        // vectorizes
+        unsigned width = static_cast<unsigned>(range_hi_) - static_cast<unsigned>(range_lo_);
+        unsigned lo = static_cast<unsigned>(range_lo_);
+        bool ret = true;
+        for (; first != last; ++first) {
+            ret &= static_cast<unsigned>(*first) - lo <= width;
+        }
+        return ret;
+    }
+
     void ArgParser::IntArg::CreateValuesIfNeed() {
         if (IsMultiValue()) {
             if (values_ == nullptr) {
@@ -279,16 +490,45 @@ namespace ArgumentParser {
         }
     }
 
+    size_t ArgParser::IntArg::ValueBytes() const {
+        size_t bytes = 0;
+        if (stored_value_ != nullptr && !stores_value_) {
+            bytes += sizeof(int);
+        }
+        if (values_ != nullptr && !stores_values_) {
+            bytes += sizeof(*values_) + VectorBytes(*values_);
+        }
+        return bytes;
+    }
+
+    void ArgParser::IntArg::SaveState(NodeState& state) const {
+        Node::SaveState(state);
+        if (IsMultiValue()) {
+            state.ints = *values_;
+        } else if (is_used_) {
+            state.ints.assign(1, *stored_value_);
+        }
+    }
+
+    void ArgParser::IntArg::RestoreState(const NodeState& state) {
+        Node::RestoreState(state);
+        CreateValuesIfNeed();
+        if (IsMultiValue()) {
+            *values_ = state.ints;
+        } else if (!state.ints.empty()) {
+            *stored_value_ = state.ints.front();
+        }
+    }
+
 
     // String arg //
-    ArgParser::StringArg::StringArg(const std::string& description, const char flag) :
+    ArgParser::StringArg::StringArg(std::string_view description, const char flag) :
         PositionalNode(description, flag) {}
     ArgParser::StringArg::~StringArg() {
-        if (stores_value_) return;
-        if (stored_value_ != nullptr) {
+        if (!stores_value_) {
             delete stored_value_;
         }
-        if (values_ != nullptr) {
+        if (!stores_values_) {
             delete values_;
         }
     }
@@ -296,6 +536,7 @@ namespace ArgumentParser {
     void ArgParser::StringArg::Reset() {
         Node::Reset();
         CreateValuesIfNeed();
+        reject_code_ = ErrorCode::kOk;
         if (IsMultiValue()) {
             values_->clear();
         } else if (has_default_) {
@@ -303,17 +544,35 @@ namespace ArgumentParser {
         }
     }
 
-    bool ArgParser::StringArg::AddValue(const std::string& val) {
+    bool ArgParser::StringArg::AddValue(std::string_view val) {
+        Touch();
         CreateValuesIfNeed();
+        if (ErrorCode code = Check(val); code != ErrorCode::kOk) {
+            if (reject_code_ == ErrorCode::kOk) {
+                reject_code_ = code;
+            }
+            return false;
+        }
         is_used_ = true;
         if (IsMultiValue()) {
-            values_->push_back(val);
+            values_->emplace_back(val);
         } else {
             *stored_value_ = val;
         }
         return true;
     }
 
+    int ArgParser::StringArg::AddValues(const std::vector<std::string>& args, int first) {
+        if (!IsMultiValue() || HasValidators()) {
+            return Node::AddValues(args, first);
+        }
+        Touch();
+        CreateValuesIfNeed();
+        is_used_ = true;
+        values_->insert(values_->end(), args.begin() + first, args.end());
+        return kNoIndex;
+    }
+
     bool ArgParser::StringArg::IsOk() const {
         if (has_default_) return true;
         if (IsMultiValue()) {
@@ -329,6 +588,21 @@ namespace ArgumentParser {
             AddSepIfNotNull(ret, sep);
             ret += "default = " + default_val_;
         }
+        if (!choices_.Empty()) {
+            AddSepIfNotNull(ret, sep);
+            ret += "choices = ";
+            for (size_t i = 0; i < choices_.Keys().size(); ++i) {
+                ret += (i == 0 ? "" : "|") + choices_.Keys()[i];
+            }
+        }
+        if (pattern_ != nullptr) {
+            AddSepIfNotNull(ret, sep);
+            ret += "pattern = " + pattern_source_;
+        }
+        if (validate_utf8_) {
+            AddSepIfNotNull(ret, sep);
+            ret += "utf-8";
+        }
         return ret;
     }
 
@@ -350,7 +624,8 @@ namespace ArgumentParser {
     }
 
     ArgParser::StringArg& ArgParser::StringArg::StoreValue(std::string& storage) {
-        if (stored_value_ != nullptr && !stores_value_) {
+        Touch();
+        if (!stores_value_) {
             delete stored_value_;
         }
         stored_value_ = &storage;
@@ -359,17 +634,45 @@ namespace ArgumentParser {
     }
 
     ArgParser::StringArg& ArgParser::StringArg::StoreValues(std::vector<std::string>& storage) {
-        if (values_ != nullptr) delete values_;
+        Touch();
+        if (!stores_values_) delete values_;
         values_ = &storage;
-        stores_value_ = true;
+        stores_values_ = true;
         return *this;
     }
 
     ArgParser::StringArg& ArgParser::StringArg::Default(const std::string& val) {
+        Touch();
+        RequirementsChanged();
         has_default_ = true;
         default_val_ = val;
         CreateValuesIfNeed();
-        *stored_value_ = default_val_;
+        if (stored_value_ != nullptr) {
+            *stored_value_ = default_val_;
+        }
+        return *this;
+    }
+
+    ArgParser::StringArg& ArgParser::StringArg::Choices(std::vector<std::string> choices) {
+        if (choices.empty()) {
+            throw std::runtime_error("Choices could not be empty");
+        }
+        RequirementsChanged();
+        choices_.Build(std::move(choices));
+        return *this;
+    }
+
+    ArgParser::StringArg& ArgParser::StringArg::Pattern(const std::string& pattern) {
+        RequirementsChanged();
+        pattern_ = std::make_unique<std::regex>(pattern,
+            std::regex::ECMAScript | std::regex::optimize);
+        pattern_source_ = pattern;
+        return *this;
+    }
+
+    ArgParser::StringArg& ArgParser::StringArg::ValidateUtf8() {
+        RequirementsChanged();
+        validate_utf8_ = true;
         return *this;
     }
 
@@ -384,6 +687,34 @@ namespace ArgumentParser {
         }
     }
 
+    std::expected<std::string_view, ErrorCode> ArgParser::StringArg::TryGetStringValue(
+        int ind) const
+    {
+        if (!is_used_ && !has_default_) {
+            return std::unexpected(ErrorCode::kNotInitialized);
+        }
+        if (!IsMultiValue()) {
+            return *stored_value_;
+        }
+        if (ind < 0 || ind >= values_->size()) {
+            return std::unexpected(ErrorCode::kIndexOutOfRange);
+        }
+        return (*values_)[ind];
+    }
+
+    ErrorCode ArgParser::StringArg::Check(std::string_view val) const {
+        if (validate_utf8_ && !IsValidUtf8(val)) {
+            return ErrorCode::kInvalidUtf8;
+        }
+        if (!choices_.Empty() && !choices_.Contains(val)) {
+            return ErrorCode::kInvalidValue;
+        }
+        if (pattern_ != nullptr && !std::regex_match(val.begin(), val.end(), *pattern_)) {
+            return ErrorCode::kInvalidValue;
+        }
+        return ErrorCode::kOk;
+    }
+
     void ArgParser::StringArg::CreateValuesIfNeed() {
         if (IsMultiValue()) {
             if (values_ == nullptr) {
@@ -393,4 +724,143 @@ namespace ArgumentParser {
             stored_value_ = new std::string(default_val_);
         }
     }
-}
\ No newline at end of file
+
+    size_t ArgParser::StringArg::SchemaBytes() const {
+        // The compiled automaton of pattern_ is not visible, only its
+        // source is counted
+        size_t bytes = sizeof(StringArg) + StringBytes(default_val_) + choices_.HeapBytes() +
+            StringBytes(pattern_source_);
+        if (pattern_ != nullptr) {
+            bytes += sizeof(*pattern_);
+        }
+        return bytes;
+    }
+
+    size_t ArgParser::StringArg::ValueBytes() const {
+        size_t bytes = 0;
+        if (stored_value_ != nullptr && !stores_value_) {
+            bytes += sizeof(*stored_value_) + StringBytes(*stored_value_);
+        }
+        if (values_ != nullptr && !stores_values_) {
+            bytes += sizeof(*values_) + VectorBytes(*values_);
+            for (const std::string& val : *values_) {
+                bytes += StringBytes(val);
+            }
+        }
+        return bytes;
+    }
+
+    void ArgParser::StringArg::SaveState(NodeState& state) const {
+        Node::SaveState(state);
+        state.reject_code = reject_code_;
+        if (IsMultiValue()) {
+            state.strings = *values_;
+        } else if (is_used_) {
+            state.strings.assign(1, *stored_value_);
+        }
+    }
+
+    void ArgParser::StringArg::RestoreState(const NodeState& state) {
+        Node::RestoreState(state);
+        CreateValuesIfNeed();
+        reject_code_ = state.reject_code;
+        if (IsMultiValue()) {
+            *values_ = state.strings;
+        } else if (!state.strings.empty()) {
+            *stored_value_ = state.strings.front();
+        }
+    }
+
+    // IntSetArg //
+    ArgParser::IntSetArg::IntSetArg(std::string_view description, const char flag) :
+        PositionalNode(description, flag) {}
+
+    void ArgParser::IntSetArg::Reset() {
+        Node::Reset();
+        value_count_ = 0;
+        if (has_default_) {
+            set_ = default_set_;
+        } else {
+            set_.Clear();
+        }
+    }
+
+    bool ArgParser::IntSetArg::AddValue(std::string_view val) {
+        Touch();
+        // Checked as a whole first, so a malformed value adds nothing
+        if (!ForEachIntSetItem(val, [](int, int) {})) {
+            return false;
+        }
+        ForEachIntSetItem(val, [this](int lo, int hi) { set_.InsertRange(lo, hi); });
+        ++value_count_;
+        is_used_ = true;
+        return true;
+    }
+
+    bool ArgParser::IntSetArg::IsOk() const {
+        if (has_default_) return true;
+        if (IsMultiValue()) {
+            return value_count_ >= min_size_;
+        } else {
+            return is_used_;
+        }
+    }
+
+    std::string ArgParser::IntSetArg::GetRequirements(std::string sep) const {
+        std::string ret = PositionalNode::GetRequirements(sep);
+        if (has_default_) {
+            AddSepIfNotNull(ret, sep);
+            ret += "default = " + default_spec_;
+        }
+        return ret;
+    }
+
+    std::string ArgParser::IntSetArg::GetLongArg(const std::string& name) const {
+        return Node::GetLongArg(name) + "=<int set>";
+    }
+
+    ArgParser::IntSetArg& ArgParser::IntSetArg::Positional() {
+        PositionalNode::Positional();
+        return *this;
+    }
+
+    ArgParser::IntSetArg& ArgParser::IntSetArg::MultiValue(int min_size) {
+        PositionalNode::MultiValue(min_size);
+        return *this;
+    }
+
+    ArgParser::IntSetArg& ArgParser::IntSetArg::Default(const std::string& spec) {
+        IntSet default_set;
+        bool is_ok = ForEachIntSetItem(spec, [&default_set](int lo, int hi) {
+            default_set.InsertRange(lo, hi);
+        });
+        if (!is_ok) {
+            throw std::runtime_error("Invalid int set: " + spec);
+        }
+        Touch();
+        RequirementsChanged();
+        has_default_ = true;
+        default_spec_ = spec;
+        default_set_ = std::move(default_set);
+        if (!is_used_) {
+            set_ = default_set_;
+        }
+        return *this;
+    }
+
+    size_t ArgParser::IntSetArg::SchemaBytes() const {
+        return sizeof(IntSetArg) + default_set_.HeapBytes() + StringBytes(default_spec_);
+    }
+
+    void ArgParser::IntSetArg::SaveState(NodeState& state) const {
+        Node::SaveState(state);
+        state.value_count = value_count_;
+        state.set = set_;
+    }
+
+    void ArgParser::IntSetArg::RestoreState(const NodeState& state) {
+        Node::RestoreState(state);
+        value_count_ = state.value_count;
+        set_ = state.set;
+    }
+}
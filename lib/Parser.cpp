@@ -1,25 +1,42 @@
 #include "ArgParser.h"
 
-std::pair<std::string, std::string> SplitByFirst(
-    const std::string& val, const char sep = '=', int start_ind = 0)
+#include <algorithm>
+#include <thread>
+
+#if defined(ARGPARSER_USDT) && __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define ARGPARSER_PROBE(name, ...) STAP_PROBEV(argparser, name, __VA_ARGS__)
+#else
+#define ARGPARSER_PROBE(name, ...)
+#endif
+
+std::pair<std::string_view, std::string_view> SplitByFirst(
+    std::string_view val, const char sep = '=', int start_ind = 0)
 {
-    size_t end_of_first = val.find('=');
-    end_of_first = end_of_first == std::string::npos ? 
+    size_t end_of_first = val.find(sep);
+    end_of_first = end_of_first == std::string_view::npos ? 
         val.size() : end_of_first;
-    std::string s1 = val.substr(start_ind, end_of_first - start_ind);
-    std::string s2 = "";
+    std::string_view s1 = val.substr(start_ind, end_of_first - start_ind);
+    std::string_view s2;
     if (end_of_first != val.size())
         s2 = val.substr(end_of_first + 1);
     return {s1, s2};
 }
 
+// Defined in Node.cpp
+std::pair<int, bool> ConvertToInt(std::string_view val);
+
+namespace {
+
+// Below this many tokens per thread starting threads costs more than it saves
+const size_t kMinPrepassChunk = 1 << 14;
+
+} // namespace
+
 namespace ArgumentParser {
 
-ArgParser::ParseData::ParseData(const std::string& cur_param_name, const bool cur_param_got_arg) :
-    cur_param_name(cur_param_name), cur_param_got_arg(cur_param_got_arg)
-{
-    cur_parse_arg = kNullString;
-}
+ArgParser::ParseData::ParseData(std::string_view cur_param_name, const bool cur_param_got_arg) :
+    cur_param_name(cur_param_name), cur_param_got_arg(cur_param_got_arg) {}
 
 bool ArgParser::Parse(const int argc, char** argv) {
     std::vector<std::string> args;
@@ -30,20 +47,371 @@ bool ArgParser::Parse(const int argc, char** argv) {
     return Parse(args);
 }
 
+// Stats policy of the ordinary Parse: every hook is empty and inlined away
+struct ArgParser::NoStats {
+    void BeginPhase() {}
+    void EndPhase(std::chrono::nanoseconds ParseStats::*) {}
+    void BeginTokenPhase(std::chrono::nanoseconds ParseStats::*) {}
+    void EndTokenPhase(std::chrono::nanoseconds ParseStats::*) {}
+    void Token(ParseArgType, std::string_view) {}
+    void Dispatch(ParseArgType, std::string_view) {}
+    template <typename Args>
+    void BulkTokens(const Args&, int) {}
+};
+
+class ArgParser::StatsCollector {
+ public:
+    StatsCollector(ParseStats& stats) : stats_(stats) {}
+
+    void BeginPhase() {
+        phase_start_ = std::chrono::steady_clock::now();
+    }
+
+    void EndPhase(std::chrono::nanoseconds ParseStats::* phase) {
+        stats_.*phase += std::chrono::steady_clock::now() - phase_start_;
+    }
+
+    // Phases that run once per token read the clock only for one call
+    // in kTimingSample, two clock reads cost about as much as the token
+    void BeginTokenPhase(std::chrono::nanoseconds ParseStats::* phase) {
+        if (SampleCount(phase) % ParseStats::kTimingSample == 0) {
+            phase_start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    void EndTokenPhase(std::chrono::nanoseconds ParseStats::* phase) {
+        if (SampleCount(phase)++ % ParseStats::kTimingSample == 0) {
+            stats_.*phase += (std::chrono::steady_clock::now() - phase_start_) *
+                ParseStats::kTimingSample;
+        }
+    }
+
+    void Token(ParseArgType type, std::string_view token) {
+        ARGPARSER_PROBE(token, static_cast<int>(type), token.size());
+        stats_.token_bytes += token.size();
+        stats_.long_tokens += token.size() > kSmallStringSize;
+        switch (type) {
+        case ParseArgType::kValue:
+            ++stats_.value_tokens;
+            break;
+        case ParseArgType::kFlag:
+            ++stats_.flag_tokens;
+            stats_.name_lookups += CountFlags(token);
+            break;
+        case ParseArgType::kArgument:
+            ++stats_.argument_tokens;
+            ++stats_.name_lookups;
+            break;
+        case ParseArgType::kUnknownArgument:
+            ++stats_.unknown_tokens;
+            ++stats_.name_lookups;
+            break;
+        case ParseArgType::kEmpty:
+            ++stats_.empty_tokens;
+            break;
+        }
+    }
+
+    void Dispatch(ParseArgType type, std::string_view token) {
+        ARGPARSER_PROBE(dispatch, static_cast<int>(type));
+        if (type == ParseArgType::kValue) {
+            ++stats_.values_dispatched;
+        } else if (type == ParseArgType::kFlag) {
+            stats_.name_lookups += CountFlags(token);
+        } else if (type == ParseArgType::kArgument) {
+            ++stats_.name_lookups;
+        }
+    }
+
+    template <typename Args>
+    void BulkTokens(const Args& args, int first) {
+        ARGPARSER_PROBE(bulk, static_cast<int>(args.size()) - first);
+        for (int i = first; i < args.size(); ++i) {
+            ++stats_.end_of_options_tokens;
+            ++stats_.values_dispatched;
+            stats_.token_bytes += args[i].size();
+            stats_.long_tokens += args[i].size() > kSmallStringSize;
+        }
+    }
+
+ private:
+    static size_t CountFlags(std::string_view token) {
+        size_t end = token.find('=');
+        return (end == std::string_view::npos ? token.size() : end) - 1;
+    }
+
+    std::uint32_t& SampleCount(std::chrono::nanoseconds ParseStats::* phase) {
+        return phase == &ParseStats::tokenize_time ? tokenize_calls_ : dispatch_calls_;
+    }
+
+    const size_t kSmallStringSize = std::string().capacity();
+    ParseStats& stats_;
+    std::chrono::steady_clock::time_point phase_start_;
+    std::uint32_t tokenize_calls_ = 0;
+    std::uint32_t dispatch_calls_ = 0;
+};
+
 bool ArgParser::Parse(const std::vector<std::string>& args) {
+    if (result_cache_.Capacity() != 0) {
+        return ParseCached(args);
+    }
+    // args[0] stands for program name
+    return ParseFrom(args, 1);
+}
+
+bool ArgParser::Parse(const std::vector<std::string>& args, ParseStats& stats) {
+    StatsCollector collector(stats);
+    return ParseWith(args, 1, collector);
+}
+
+bool ArgParser::ParseFrom(const std::vector<std::string>& args, int first_ind) {
+    NoStats stats;
+    return ParseWith(args, first_ind, stats);
+}
+
+bool ArgParser::ParseCommandLine(std::string_view command_line) {
+    if (!tokenizer_.Tokenize(command_line)) {
+        Reset();
+        SetParseError(ErrorCode::kInvalidCommandLine, tokenizer_.Tokens().size());
+        good_parse_ = false;
+        return false;
+    }
+    NoStats stats;
+    return ParseWith(tokenizer_.Tokens(), 1, stats);
+}
+
+bool ArgParser::ParseCached(const std::vector<std::string>& args) {
+    // Reset first: it settles a pending positional argument, which is a
+    // schema change of its own
     Reset();
+    if (cache_version_ != node_context_->schema_version) {
+        result_cache_.Clear();
+        cache_version_ = node_context_->schema_version;
+    }
+    std::uint64_t hash = HashArgs(args);
+    if (const CachedParse* cached = result_cache_.Find(args, hash)) {
+        for (const NodeState& state : cached->states) {
+            state.node->RestoreState(state);
+        }
+        good_parse_ = cached->good_parse;
+        parse_error_ = cached->parse_error;
+        unknown_param_ = cached->unknown_param;
+        last_args_hash_ = hash;
+        return cached->result;
+    }
+    bool result = ParseFrom(args, 1);
+    // The state of the sub-parser is not saved
+    if (HasSubcommand()) {
+        return result;
+    }
+    CachedParse& cached = result_cache_.Insert(args, hash);
+    cached.states.resize(node_context_->touched.size());
+    for (size_t i = 0; i < cached.states.size(); ++i) {
+        cached.states[i].node = node_context_->touched[i];
+        node_context_->touched[i]->SaveState(cached.states[i]);
+    }
+    cached.result = result;
+    cached.good_parse = good_parse_;
+    cached.parse_error = parse_error_;
+    cached.unknown_param = unknown_param_;
+    return result;
+}
+
+void ArgParser::TraceParse(const std::vector<std::string>& args, ParseTrace& trace) {
+    bool good_parse = good_parse_;
+    trace_ = &trace;
+    NoStats stats;
+    ParseWith(args, 1, stats);
+    trace_ = nullptr;
+    good_parse_ = good_parse;
+    // Groups the operations by argument, keeping their order
+    std::stable_sort(trace.ops.begin(), trace.ops.end(),
+        [](const TraceOp& lhs, const TraceOp& rhs) { return lhs.param < rhs.param; });
+}
+
+bool ArgParser::Reparse(const std::vector<std::string>& old_args,
+    const std::vector<std::string>& new_args, std::vector<std::string>& changed)
+{
+    changed.clear();
+    auto all_changed = [this, &changed]() {
+        for (const auto& [param, ptr] : name_to_argument_node_) {
+            changed.emplace_back(param);
+        }
+    };
+    if (need_update_ || need_index_ || node_context_->requirements_changed ||
+        last_args_hash_ != HashArgs(old_args))
+    {
+        all_changed();
+        return Parse(new_args);
+    }
+    if (old_args == new_args) {
+        return Help() || good_parse_;
+    }
+    // The kept trace stands for old_args when the last Reparse went to
+    // them under the same schema
+    bool is_kept = kept_trace_.is_valid &&
+        kept_trace_.schema_version == node_context_->schema_version &&
+        kept_trace_.args == old_args;
+    ParseTrace traced;
+    if (!is_kept) {
+        TraceParse(old_args, traced);
+    }
+    const ParseTrace& old_trace = is_kept ? kept_trace_.trace : traced;
+    // The new trace views into trace_args_, which is kept in its place
+    // for the next call
+    trace_args_ = new_args;
+    ParseTrace new_trace;
+    TraceParse(trace_args_, new_trace);
+    if (!old_trace.is_replayable || !new_trace.is_replayable) {
+        kept_trace_.is_valid = false;
+        all_changed();
+        return Parse(new_args);
+    }
+
+    // Both traces are sorted by argument, walk them together and keep
+    // the new operations of every argument whose operations differ
+    using Range = std::pair<std::vector<TraceOp>::const_iterator,
+        std::vector<TraceOp>::const_iterator>;
+    auto next_range = [](const std::vector<TraceOp>& ops, auto first) {
+        auto last = first;
+        while (last != ops.end() && last->param == first->param) {
+            ++last;
+        }
+        return Range(first, last);
+    };
+    auto is_same_op = [](const TraceOp& lhs, const TraceOp& rhs) {
+        return lhs.is_call == rhs.is_call && lhs.value == rhs.value;
+    };
+    std::vector<Range> replay;
+    auto old_it = old_trace.ops.cbegin();
+    auto new_it = new_trace.ops.cbegin();
+    while (old_it != old_trace.ops.cend() || new_it != new_trace.ops.cend()) {
+        bool has_old = old_it != old_trace.ops.cend() &&
+            (new_it == new_trace.ops.cend() || old_it->param <= new_it->param);
+        bool has_new = new_it != new_trace.ops.cend() &&
+            (old_it == old_trace.ops.cend() || new_it->param <= old_it->param);
+        Range old_range = has_old ? next_range(old_trace.ops, old_it) : Range(old_it, old_it);
+        Range new_range = has_new ? next_range(new_trace.ops, new_it) : Range(new_it, new_it);
+        if (!std::equal(old_range.first, old_range.second, new_range.first, new_range.second,
+            is_same_op))
+        {
+            changed.emplace_back(has_new ? new_it->param : old_it->param);
+            replay.push_back(new_range);
+        }
+        old_it = old_range.second;
+        new_it = new_range.second;
+    }
+    // Swapping moves neither the operations nor the strings, so replay
+    // and the views stay valid
+    std::swap(kept_trace_.trace, new_trace);
+    std::swap(kept_trace_.args, trace_args_);
+    kept_trace_.schema_version = node_context_->schema_version;
+    kept_trace_.is_valid = true;
+
+    // Errors other than a missing argument carry token positions that
+    // only a full parse reproduces
+    if (parse_error_.code != ErrorCode::kOk && parse_error_.code != ErrorCode::kMissingArgument) {
+        return Parse(new_args);
+    }
+    for (int i = 0; i < changed.size(); ++i) {
+        Node& node = GetArg(changed[i]);
+        node.Reset();
+        for (auto it = replay[i].first; it != replay[i].second; ++it) {
+            if (it->is_call) {
+                node.ArgCalled();
+            } else if (!node.AddValue(it->value)) {
+                return Parse(new_args);
+            }
+        }
+    }
+    good_parse_ = true;
+    parse_error_ = ParseError();
+    last_args_hash_ = HashArgs(new_args);
+    if (Help()) {
+        return true;
+    }
+    if (!CheckArgsAreOk()) {
+        SetParseError(ErrorCode::kMissingArgument, kNoIndex);
+        good_parse_ = false;
+    }
+    return good_parse_;
+}
+
+template <typename Args, typename Stats>
+bool ArgParser::ParseWith(const Args& args, int first_ind, Stats& stats) {
+    // A traced parse leaves the nodes and the parse state alone
+    const bool is_trace = trace_ != nullptr;
+    stats.BeginPhase();
+    if (!is_trace) {
+        Reset();
+        // Sub-parsers start midway through the vector of their parent
+        if (first_ind == 1) {
+            last_args_hash_ = HashArgs(args);
+        }
+    }
+    stats.EndPhase(&ParseStats::reset_time);
     int argc = args.size();
+    // Subcommands switch to another parser midway, so their tokens are
+    // classified by it as they come
+    const Prepass* prepass = nullptr;
+    if (!is_trace && subcommands_.empty() && parallel_threshold_ != 0 &&
+        argc - first_ind >= static_cast<int>(parallel_threshold_))
+    {
+        stats.BeginPhase();
+        RunPrepass(args, first_ind);
+        prepass = &prepass_;
+        stats.EndPhase(&ParseStats::tokenize_time);
+    }
     ParseData parse_data;
-    parse_data.next_ind = 1;
-    // args[0] stands for program name
+    parse_data.next_ind = first_ind;
     while (true) {
-        if (parse_data.cur_parse_arg == kNullString) {
+        if (parse_data.cur_parse_arg.empty()) {
             if (parse_data.next_ind >= argc){
                 break;
             }
-            parse_data.cur_parse_arg = args[parse_data.next_ind++];
-            parse_data.cur_type = GetParseArgType(parse_data.cur_parse_arg);
+            // As with getopt, "--" right after an option that needs a
+            // value is that value
+            if (args[parse_data.next_ind] == kEndOfOptions && !AwaitsValue(parse_data)) {
+                // Everything after "--" is positional, no classification needed
+                stats.BeginPhase();
+                stats.BulkTokens(args, parse_data.next_ind + 1);
+                int bad_ind = prepass != nullptr && CheckType(ArgType::kIntArg, positional_param_) ?
+                    AddToPostional(*prepass, parse_data.next_ind + 1) :
+                    AddToPostional(args, parse_data.next_ind + 1);
+                stats.EndPhase(&ParseStats::dispatch_time);
+                if (bad_ind != kNoIndex) {
+                    SetParseError(positional_param_ == kNoneParamName ?
+                        ErrorCode::kNoPositional : GetArg(positional_param_).GetRejectCode(),
+                        bad_ind);
+                    good_parse_ = false;
+                }
+                break;
+            }
+            stats.BeginTokenPhase(&ParseStats::tokenize_time);
+            int token = parse_data.next_ind++;
+            parse_data.cur_parse_arg = args[token];
+            if (prepass != nullptr) {
+                parse_data.cur_type = prepass->types[token];
+                parse_data.cur_converted = &prepass->ints[token];
+            } else {
+                parse_data.cur_type = GetParseArgType(parse_data.cur_parse_arg);
+            }
+            stats.Token(parse_data.cur_type, parse_data.cur_parse_arg);
+            stats.EndTokenPhase(&ParseStats::tokenize_time);
+            if (IsSubcommand(parse_data) && is_trace) {
+                trace_->is_replayable = false;
+                break;
+            }
+            if (IsSubcommand(parse_data)) {
+                // The rest of args belongs to the sub-parser
+                selected_subcommand_ = std::string(parse_data.cur_parse_arg);
+                good_parse_ &= GetSubparser(selected_subcommand_)
+                    .ParseWith(args, parse_data.next_ind, stats);
+                break;
+            }
         }
+        stats.BeginTokenPhase(&ParseStats::dispatch_time);
+        stats.Dispatch(parse_data.cur_type, parse_data.cur_parse_arg);
         switch (parse_data.cur_type)
         {
         case ParseArgType::kValue:
@@ -55,32 +423,99 @@ bool ArgParser::Parse(const std::vector<std::string>& args) {
         case ParseArgType::kArgument:
             good_parse_ &= ProcessArgument(parse_data);
             break;
+        case ParseArgType::kUnknownArgument:
+            good_parse_ &= ProcessUnknownArgument(parse_data);
+            break;
         case ParseArgType::kEmpty:
-            continue;
         default:
             break;
         }
+        stats.EndTokenPhase(&ParseStats::dispatch_time);
+    }
+    if (is_trace) {
+        return true;
     }
     if (Help()) {
-        std::cout << HelpDescription() << "\n";
         return true;
     }
-    good_parse_ &= CheckArgsAreOk();
+    stats.BeginPhase();
+    if (!CheckArgsAreOk()) {
+        SetParseError(ErrorCode::kMissingArgument, kNoIndex);
+        good_parse_ = false;
+    }
+    stats.EndPhase(&ParseStats::validate_time);
     return good_parse_;
 }
 
+template <typename Args>
+void ArgParser::RunPrepass(const Args& args, int first_ind) {
+    prepass_.types.resize(args.size());
+    prepass_.ints.resize(args.size());
+    auto classify = [this, &args](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            prepass_.types[i] = GetParseArgType(args[i]);
+            // Every token, not only kValue ones: after "--" a token such as
+            // "-1" is a value even when it names a flag
+            prepass_.ints[i] = ConvertToInt(args[i]);
+        }
+    };
+    // Contiguous chunks, so every thread writes its own cache lines
+    size_t size = args.size() - first_ind;
+    size_t chunks = std::max(1u, std::thread::hardware_concurrency());
+    chunks = std::clamp<size_t>(size / kMinPrepassChunk, 1, chunks);
+    std::vector<std::thread> workers;
+    workers.reserve(chunks - 1);
+    for (size_t i = 1; i < chunks; ++i) {
+        workers.emplace_back(classify, first_ind + i * size / chunks,
+            first_ind + (i + 1) * size / chunks);
+    }
+    classify(first_ind, first_ind + size / chunks);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+bool ArgParser::IsSubcommand(const ParseData& parse_data) const {
+    if (subcommands_.empty() || parse_data.cur_type != ParseArgType::kValue) {
+        return false;
+    }
+    // A value still awaited by the current option is not a subcommand
+    if (AwaitsValue(parse_data)) {
+        return false;
+    }
+    return subcommands_.contains(parse_data.cur_parse_arg);
+}
+
+bool ArgParser::AwaitsValue(const ParseData& parse_data) const {
+    return parse_data.cur_param_name != kNoneParamName && !parse_data.cur_param_got_arg &&
+        name_to_argument_node_.find(parse_data.cur_param_name)->second->TakesArgument();
+}
+
 bool ArgParser::ProcessValue(ParseData& parse_data) {
     bool is_good = true;
-    if (parse_data.cur_param_name == kNoneParamName) {
-        is_good &= AddToPostional(parse_data.cur_parse_arg);
-    } else if (GetArg(parse_data.cur_param_name).TakesArgument() &&
-        (GetArg(parse_data.cur_param_name).IsMultiValue() || !parse_data.cur_param_got_arg))
-    {
-        is_good &= GetArg(parse_data.cur_param_name).AddValue(parse_data.cur_parse_arg);
+    bool to_positional = true;
+    if (parse_data.cur_param_name != kNoneParamName) {
+        const Node& node = GetArg(parse_data.cur_param_name);
+        to_positional = !node.TakesArgument() ||
+            (!node.IsMultiValue() && parse_data.cur_param_got_arg);
+    }
+    if (to_positional) {
+        is_good &= AddToPostional(parse_data.cur_parse_arg, parse_data.cur_converted);
     } else {
-        is_good &= AddToPostional(parse_data.cur_parse_arg);
+        is_good &= AddValueTo(parse_data.cur_param_name, parse_data.cur_parse_arg,
+            parse_data.cur_converted);
     }
-    parse_data.cur_parse_arg = kNullString;
+    if (!is_good) {
+        ErrorCode code = ErrorCode::kNoPositional;
+        if (!to_positional) {
+            code = GetArg(parse_data.cur_param_name).GetRejectCode();
+        } else if (positional_param_ != kNoneParamName) {
+            code = GetArg(positional_param_).GetRejectCode();
+        }
+        SetParseError(code, parse_data.next_ind - 1);
+    }
+    parse_data.cur_parse_arg = {};
+    parse_data.cur_converted = nullptr;
     parse_data.cur_type = ParseArgType::kEmpty;
     parse_data.cur_param_got_arg = true;
     return is_good;
@@ -89,16 +524,14 @@ bool ArgParser::ProcessValue(ParseData& parse_data) {
 bool ArgParser::ProcessFlag(ParseData& parse_data) {
     parse_data.cur_param_got_arg = false;
     auto [flags, arg] = SplitByFirst(parse_data.cur_parse_arg, '=', 1);
-    if (arg.empty()) {
-        arg = kNullString;
-    }
+    parse_data.cur_converted = nullptr;
     for (int i = 0; i < flags.size(); ++i) {
         char flag = flags[i];
         parse_data.cur_param_name = GetParamByFlag(flag);
         ArgCalled(parse_data.cur_param_name);
     }
     parse_data.cur_parse_arg = arg;
-    if (arg != kNullString) {
+    if (!arg.empty()) {
         parse_data.cur_type = ParseArgType::kValue;
     } else {
         parse_data.cur_type = ParseArgType::kEmpty;
@@ -109,22 +542,45 @@ bool ArgParser::ProcessFlag(ParseData& parse_data) {
 bool ArgParser::ProcessArgument(ParseData& parse_data) {
     parse_data.cur_param_got_arg = false;
     int arg_size = parse_data.cur_parse_arg.size();
-    std::string param = GetParamByLongArg(parse_data.cur_parse_arg);
+    std::string_view written_param = GetParamByLongArg(parse_data.cur_parse_arg);
+    std::string_view param = ResolveParam(written_param);
     ArgCalled(param);
     parse_data.cur_param_name = param;
-    if (param.size() == arg_size - 2) {
-        parse_data.cur_parse_arg = kNullString;
+    parse_data.cur_converted = nullptr;
+    if (written_param.size() == arg_size - 2) {
+        parse_data.cur_parse_arg = {};
         parse_data.cur_type = ParseArgType::kEmpty;
         parse_data.cur_param_got_arg = false;
     } else {
-        parse_data.cur_parse_arg = parse_data.cur_parse_arg.substr(2 + param.size() + 1);
+        parse_data.cur_parse_arg = parse_data.cur_parse_arg.substr(2 + written_param.size() + 1);
         parse_data.cur_type = ParseArgType::kValue;
         parse_data.cur_param_got_arg = false;
     }
     return true;
 }
 
-ArgParser::ParseArgType ArgParser::GetParseArgType(const std::string& arg) const {
+bool ArgParser::ProcessUnknownArgument(ParseData& parse_data) {
+    // Only the first unknown option is reported
+    if (trace_ != nullptr) {
+        trace_->is_replayable = false;
+    } else if (unknown_param_ == kNoneParamName) {
+        unknown_param_ = std::string(GetParamByLongArg(parse_data.cur_parse_arg));
+        // With abbreviations a prefix of several names is not unknown
+        auto [first, last] = long_names_.Range(unknown_param_);
+        bool is_ambiguous = allow_abbreviations_ && !unknown_param_.empty() &&
+            last - first > 1;
+        SetParseError(is_ambiguous ? ErrorCode::kAmbiguousArgument :
+            ErrorCode::kUnknownArgument, parse_data.next_ind - 1);
+    }
+    parse_data.cur_param_name = kNoneParamName;
+    parse_data.cur_param_got_arg = false;
+    parse_data.cur_parse_arg = {};
+    parse_data.cur_converted = nullptr;
+    parse_data.cur_type = ParseArgType::kEmpty;
+    return false;
+}
+
+ArgParser::ParseArgType ArgParser::GetParseArgType(std::string_view arg) const {
     if (arg.empty()) {
         return ParseArgType::kEmpty;
     }
@@ -146,22 +602,28 @@ ArgParser::ParseArgType ArgParser::GetParseArgType(const std::string& arg) const
         return ParseArgType::kFlag;
     }
     // arg[0, 1] == "--"
-    std::string potential_argument = GetParamByLongArg(arg);
+    std::string_view potential_argument = ResolveParam(GetParamByLongArg(arg));
     if (ValidateParam(potential_argument)) {
         return ParseArgType::kArgument;
     }
-    return ParseArgType::kValue;
+    return ParseArgType::kUnknownArgument;
 }
 
-std::string ArgParser::GetParamByLongArg(const std::string& long_arg) const {
+std::string_view ArgParser::GetParamByLongArg(std::string_view long_arg) const {
     if (long_arg.size() < 2) {
-        return kNullString;
+        return {};
     }
     size_t end_of_argument = long_arg.find('=');
-    end_of_argument = end_of_argument == std::string::npos ? 
+    end_of_argument = end_of_argument == std::string_view::npos ? 
         long_arg.size() : end_of_argument;
-    std::string param = long_arg.substr(2, end_of_argument - 2);
-    return param;
+    return long_arg.substr(2, end_of_argument - 2);
+}
+
+std::string_view ArgParser::ResolveParam(std::string_view param) const {
+    if (!allow_abbreviations_ || param.empty() || ValidateParam(param)) {
+        return param;
+    }
+    return long_names_.UniqueMatch(param);
 }
 
 }
@@ -0,0 +1,51 @@
+#include "PrefixIndex.h"
+
+#include "MemoryReport.h"
+
+#include <algorithm>
+
+namespace ArgumentParser {
+
+void PrefixIndex::Build(std::vector<std::string> names) {
+    names_ = std::move(names);
+    std::sort(names_.begin(), names_.end());
+}
+
+std::pair<PrefixIndex::Iterator, PrefixIndex::Iterator> PrefixIndex::Range(
+    std::string_view prefix) const
+{
+    Iterator first = LowerBound(prefix);
+    Iterator last = first;
+    while (last != names_.end() && last->starts_with(prefix)) {
+        ++last;
+    }
+    return {first, last};
+}
+
+std::string_view PrefixIndex::UniqueMatch(std::string_view prefix) const {
+    Iterator first = LowerBound(prefix);
+    if (first == names_.end() || !first->starts_with(prefix)) {
+        return {};
+    }
+    // Sorted order puts an exact match first among the names it prefixes
+    Iterator next = std::next(first);
+    if (*first == prefix || next == names_.end() || !next->starts_with(prefix)) {
+        return *first;
+    }
+    return {};
+}
+
+PrefixIndex::Iterator PrefixIndex::LowerBound(std::string_view prefix) const {
+    return std::lower_bound(names_.begin(), names_.end(), prefix,
+        [](const std::string& name, std::string_view val) { return name < val; });
+}
+
+size_t PrefixIndex::HeapBytes() const {
+    size_t bytes = VectorBytes(names_);
+    for (const std::string& name : names_) {
+        bytes += StringBytes(name);
+    }
+    return bytes;
+}
+
+} // namespace ArgumentParser
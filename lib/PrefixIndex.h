@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ArgumentParser {
+
+// Sorted index over long argument names. All names sharing a prefix form
+// one contiguous range, so lookups are a binary search plus the matches.
+class PrefixIndex {
+ public:
+    using Iterator = std::vector<std::string>::const_iterator;
+
+    void Build(std::vector<std::string> names);
+    std::pair<Iterator, Iterator> Range(std::string_view prefix) const;
+    // Exact name, or the only name starting with prefix; empty otherwise
+    std::string_view UniqueMatch(std::string_view prefix) const;
+    size_t Size() const { return names_.size(); }
+    size_t HeapBytes() const;
+
+ private:
+    Iterator LowerBound(std::string_view prefix) const;
+
+    std::vector<std::string> names_;
+};
+
+} // namespace ArgumentParser
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ArgumentParser {
+
+// Counters of a result cache, see ArgParser::EnableResultCache
+struct ResultCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    size_t size = 0;
+};
+
+// Hash of an argument vector, Args is std::vector<std::string> or
+// std::vector<std::string_view>
+template <typename Args>
+std::uint64_t HashArgs(const Args& args) {
+    std::uint64_t hash = args.size();
+    for (std::string_view arg : args) {
+        hash ^= std::hash<std::string_view>{}(arg) + 0x9E3779B97F4A7C15ull +
+            (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+// Bounded map from argument vectors to T that evicts the least recently
+// used entry. Entries are found by a hash of the vector and confirmed by
+// comparing the vectors, so a hash collision costs a compare and never
+// returns another vector's entry.
+template <typename T>
+class ResultCache {
+ public:
+    // 0 turns the cache off and drops every entry
+    void SetCapacity(size_t capacity) {
+        capacity_ = capacity;
+        while (entries_.size() > capacity_) {
+            Evict();
+        }
+    }
+    size_t Capacity() const { return capacity_; }
+
+    // Marks the entry as the most recently used one; counts a hit or a miss
+    T* Find(const std::vector<std::string>& args, std::uint64_t hash) {
+        auto [first, last] = index_.equal_range(hash);
+        for (auto it = first; it != last; ++it) {
+            if (it->second->args == args) {
+                entries_.splice(entries_.begin(), entries_, it->second);
+                ++stats_.hits;
+                return &it->second->value;
+            }
+        }
+        ++stats_.misses;
+        return nullptr;
+    }
+
+    // args must not be in the cache and the capacity must not be 0
+    T& Insert(const std::vector<std::string>& args, std::uint64_t hash) {
+        if (entries_.size() == capacity_) {
+            Evict();
+        }
+        entries_.push_front(Entry{hash, args, T()});
+        index_.emplace(hash, entries_.begin());
+        stats_.size = entries_.size();
+        return entries_.front().value;
+    }
+
+    // Drops the entries, the counters are kept
+    void Clear() {
+        entries_.clear();
+        index_.clear();
+        stats_.size = 0;
+    }
+
+    const ResultCacheStats& Stats() const { return stats_; }
+
+ private:
+    struct Entry {
+        std::uint64_t hash;
+        std::vector<std::string> args;
+        T value;
+    };
+
+    void Evict() {
+        auto [first, last] = index_.equal_range(entries_.back().hash);
+        for (auto it = first; it != last; ++it) {
+            if (it->second == std::prev(entries_.end())) {
+                index_.erase(it);
+                break;
+            }
+        }
+        entries_.pop_back();
+        ++stats_.evictions;
+        stats_.size = entries_.size();
+    }
+
+    // Most recently used first
+    std::list<Entry> entries_;
+    std::unordered_multimap<std::uint64_t, typename std::list<Entry>::iterator> index_;
+    size_t capacity_ = 0;
+    ResultCacheStats stats_;
+};
+
+} // namespace ArgumentParser
@@ -0,0 +1,367 @@
+#include "ArgParser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ArgumentParser {
+
+namespace {
+
+const char kSchemaMagic[8] = {'A', 'R', 'G', 'S', 'C', 'H', 'M', '\0'};
+// 2: records in registration order instead of sorted by name
+const std::uint32_t kSchemaVersion = 2;
+
+const std::uint8_t kAttrPositional = 1 << 0;
+const std::uint8_t kAttrMultiValue = 1 << 1;
+const std::uint8_t kAttrHasDefault = 1 << 2;
+
+const std::uint8_t kRecordInt = 0;
+const std::uint8_t kRecordString = 1;
+const std::uint8_t kRecordBool = 2;
+const std::uint8_t kRecordHelp = 3;
+
+// All fields are fixed-size and every string is addressed by an offset
+// into the string table, so the blob does not depend on where it is mapped.
+struct SchemaStringRef {
+    std::uint32_t offset;
+    std::uint32_t size;
+};
+
+struct SchemaHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t record_count;
+    std::uint64_t schema_hash;
+    SchemaStringRef program_description;
+    std::uint32_t strings_offset;
+    std::uint32_t strings_size;
+};
+
+struct SchemaRecord {
+    SchemaStringRef name;
+    SchemaStringRef description;
+    SchemaStringRef default_string;
+    std::int32_t default_int;
+    std::int32_t min_size;
+    std::uint8_t type;
+    std::uint8_t flag;
+    std::uint8_t attributes;
+    std::uint8_t reserved;
+};
+
+// FNV-1a fed piece by piece, so a blob can be hashed without building it
+class Fnv1a {
+ public:
+    void Add(std::string_view data) {
+        for (unsigned char c : data) {
+            hash_ ^= c;
+            hash_ *= 1099511628211ull;
+        }
+    }
+    std::uint64_t Hash() const { return hash_; }
+
+ private:
+    std::uint64_t hash_ = 14695981039346656037ull;
+};
+
+SchemaStringRef AddString(std::string& strings, std::string_view val) {
+    SchemaStringRef ref{static_cast<std::uint32_t>(strings.size()),
+        static_cast<std::uint32_t>(val.size())};
+    strings.append(val);
+    return ref;
+}
+
+template <typename T>
+T ReadAt(std::string_view blob, size_t offset) {
+    T ret;
+    std::memcpy(&ret, blob.data() + offset, sizeof(T));
+    return ret;
+}
+
+// Sinks of ArgParser::WriteSchema. String() gets the strings in string
+// table order and returns where they are placed.
+
+// Builds the records and the string table of a blob
+struct BlobSink {
+    std::vector<SchemaRecord> records;
+    std::string strings;
+
+    SchemaStringRef String(std::string_view val) { return AddString(strings, val); }
+    void Record(const SchemaRecord& record) { records.push_back(record); }
+};
+
+// First pass of SchemaHash: hashes the records, only lays out the strings
+struct RecordHashSink {
+    Fnv1a& hash;
+    std::uint32_t strings_size = 0;
+
+    SchemaStringRef String(std::string_view val) {
+        SchemaStringRef ref{strings_size, static_cast<std::uint32_t>(val.size())};
+        strings_size += val.size();
+        return ref;
+    }
+    void Record(const SchemaRecord& record) {
+        hash.Add(std::string_view(reinterpret_cast<const char*>(&record), sizeof(record)));
+    }
+};
+
+// Second pass of SchemaHash: hashes the string table
+struct StringHashSink {
+    Fnv1a& hash;
+
+    SchemaStringRef String(std::string_view val) {
+        hash.Add(val);
+        return {};
+    }
+    void Record(const SchemaRecord&) {}
+};
+
+} // namespace
+
+std::vector<std::string_view> ArgParser::SchemaOrder() const {
+    // Records are in registration (node id) order: LoadSchema registers
+    // them in the same order, so help rows and the missing argument
+    // reported first stay the same. Ids do not depend on the iteration
+    // order of name_to_argument_node_, and neither does the hash.
+    std::vector<std::pair<int, std::string_view>> ids;
+    ids.reserve(name_to_argument_node_.size());
+    for (const auto& [param, ptr] : name_to_argument_node_) {
+        ids.emplace_back(ptr->GetId(), param);
+    }
+    std::sort(ids.begin(), ids.end());
+    std::vector<std::string_view> names;
+    names.reserve(ids.size());
+    for (const auto& [id, param] : ids) {
+        names.push_back(param);
+    }
+    return names;
+}
+
+template <typename Sink>
+void ArgParser::WriteSchema(const std::vector<std::string_view>& names, Sink& sink) const {
+    // A blob that silently dropped them would load as a different schema
+    if (!subcommands_.empty()) {
+        throw std::runtime_error("Schema cannot encode subcommands");
+    }
+    // Offsets and sizes are 32-bit, so the whole blob must stay below 4 GiB
+    size_t blob_size = sizeof(SchemaHeader);
+    auto add_string = [&sink, &blob_size](std::string_view val) {
+        blob_size += val.size();
+        return sink.String(val);
+    };
+    for (std::string_view name : names) {
+        const Node& node = *name_to_argument_node_.find(name)->second;
+        if (node.HasValidators()) {
+            throw std::runtime_error("Schema cannot encode validators of argument: " +
+                std::string(name));
+        }
+        SchemaRecord record{};
+        record.name = add_string(name);
+        record.description = add_string(node.GetDescription());
+        record.flag = static_cast<std::uint8_t>(node.GetFlagChar());
+        if (node.HasDefault()) {
+            record.attributes |= kAttrHasDefault;
+        }
+        if (node.IsMultiValue()) {
+            record.attributes |= kAttrMultiValue;
+        }
+        switch (node.GetType()) {
+        case ArgType::kIntArg: {
+            const IntArg& arg = static_cast<const IntArg&>(node);
+            record.type = kRecordInt;
+            record.default_int = arg.GetDefault();
+            record.min_size = arg.GetMinSize();
+            record.attributes |= arg.IsPositional() ? kAttrPositional : 0;
+            break;
+        }
+        case ArgType::kStringArg: {
+            const StringArg& arg = static_cast<const StringArg&>(node);
+            record.type = kRecordString;
+            record.default_string = add_string(arg.GetDefault());
+            record.min_size = arg.GetMinSize();
+            record.attributes |= arg.IsPositional() ? kAttrPositional : 0;
+            break;
+        }
+        case ArgType::kBoolArg:
+            record.type = kRecordBool;
+            record.default_int = static_cast<const BoolArg&>(node).GetDefault();
+            break;
+        case ArgType::kHelp:
+            record.type = kRecordHelp;
+            break;
+        default:
+            throw std::runtime_error("Schema cannot encode argument: " + std::string(name));
+        }
+        sink.Record(record);
+        blob_size += sizeof(SchemaRecord);
+    }
+    add_string(program_description_);
+    if (blob_size > UINT32_MAX) {
+        throw std::runtime_error("Schema does not fit into 4 GiB");
+    }
+}
+
+std::uint64_t ArgParser::SchemaHash() const {
+    // Same bytes as the blob after the header: the records, then the
+    // string table, which the first pass only lays out
+    std::vector<std::string_view> names = SchemaOrder();
+    Fnv1a hash;
+    RecordHashSink records{hash};
+    WriteSchema(names, records);
+    StringHashSink strings{hash};
+    WriteSchema(names, strings);
+    return hash.Hash();
+}
+
+std::string ArgParser::SerializeSchema() const {
+    BlobSink sink;
+    WriteSchema(SchemaOrder(), sink);
+    // The program description is the last string of the table
+    std::uint32_t description_size = program_description_.size();
+
+    SchemaHeader header{};
+    std::memcpy(header.magic, kSchemaMagic, sizeof(kSchemaMagic));
+    header.version = kSchemaVersion;
+    header.record_count = sink.records.size();
+    header.program_description = SchemaStringRef{
+        static_cast<std::uint32_t>(sink.strings.size()) - description_size, description_size};
+    header.strings_offset = sizeof(SchemaHeader) + sink.records.size() * sizeof(SchemaRecord);
+    header.strings_size = sink.strings.size();
+
+    std::string blob(header.strings_offset, '\0');
+    std::memcpy(blob.data() + sizeof(SchemaHeader), sink.records.data(),
+        sink.records.size() * sizeof(SchemaRecord));
+    blob += sink.strings;
+    Fnv1a hash;
+    hash.Add(std::string_view(blob).substr(sizeof(SchemaHeader)));
+    header.schema_hash = hash.Hash();
+    std::memcpy(blob.data(), &header, sizeof(SchemaHeader));
+    return blob;
+}
+
+bool ArgParser::SaveSchema(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    std::string blob = SerializeSchema();
+    out.write(blob.data(), blob.size());
+    return static_cast<bool>(out);
+}
+
+bool ArgParser::LoadSchema(std::string_view blob, std::uint64_t expected_hash) {
+    if (!name_to_argument_node_.empty() || blob.size() < sizeof(SchemaHeader)) {
+        return false;
+    }
+    SchemaHeader header = ReadAt<SchemaHeader>(blob, 0);
+    if (std::memcmp(header.magic, kSchemaMagic, sizeof(kSchemaMagic)) != 0 ||
+        header.version != kSchemaVersion ||
+        header.schema_hash != expected_hash)
+    {
+        return false;
+    }
+    size_t records_size = static_cast<size_t>(header.record_count) * sizeof(SchemaRecord);
+    if (header.strings_offset != sizeof(SchemaHeader) + records_size ||
+        static_cast<size_t>(header.strings_offset) + header.strings_size != blob.size())
+    {
+        return false;
+    }
+    Fnv1a hash;
+    hash.Add(blob.substr(sizeof(SchemaHeader)));
+    if (hash.Hash() != header.schema_hash) {
+        return false;
+    }
+    std::string_view strings = blob.substr(header.strings_offset);
+    auto get_string = [&strings](SchemaStringRef ref, std::string_view& out) {
+        if (ref.offset > strings.size() || ref.size > strings.size() - ref.offset) {
+            return false;
+        }
+        out = strings.substr(ref.offset, ref.size);
+        return true;
+    };
+    // Validate every record before touching the parser, so a broken blob
+    // never leaves it half-loaded.
+    for (std::uint32_t i = 0; i < header.record_count; ++i) {
+        SchemaRecord record = ReadAt<SchemaRecord>(blob, sizeof(SchemaHeader) + i * sizeof(SchemaRecord));
+        std::string_view unused;
+        if (record.type > kRecordHelp ||
+            !get_string(record.name, unused) ||
+            !get_string(record.description, unused) ||
+            !get_string(record.default_string, unused))
+        {
+            return false;
+        }
+    }
+    std::string_view program_description;
+    if (!get_string(header.program_description, program_description)) {
+        return false;
+    }
+
+    // One copy of the whole string table; names and descriptions are
+    // views into it instead of a copy each
+    strings = Intern(strings);
+    name_to_argument_node_.reserve(header.record_count);
+    for (std::uint32_t i = 0; i < header.record_count; ++i) {
+        SchemaRecord record = ReadAt<SchemaRecord>(blob, sizeof(SchemaHeader) + i * sizeof(SchemaRecord));
+        std::string_view name, description, default_string;
+        get_string(record.name, name);
+        get_string(record.description, description);
+        get_string(record.default_string, default_string);
+        const char flag = static_cast<char>(record.flag);
+        const bool has_default = record.attributes & kAttrHasDefault;
+        switch (record.type) {
+        case kRecordInt: {
+            IntArg& arg = RegisterInt(flag, name, description);
+            if (record.attributes & kAttrMultiValue) arg.MultiValue(record.min_size);
+            if (record.attributes & kAttrPositional) arg.Positional();
+            if (has_default) arg.Default(record.default_int);
+            break;
+        }
+        case kRecordString: {
+            StringArg& arg = RegisterString(flag, name, description);
+            if (record.attributes & kAttrMultiValue) arg.MultiValue(record.min_size);
+            if (record.attributes & kAttrPositional) arg.Positional();
+            if (has_default) arg.Default(std::string(default_string));
+            break;
+        }
+        case kRecordBool: {
+            BoolArg& arg = RegisterFlag(flag, name, description);
+            if (has_default) arg.Default(record.default_int != 0);
+            break;
+        }
+        case kRecordHelp:
+            AddHelp(flag, std::string(name), std::string(program_description));
+            break;
+        }
+    }
+    return true;
+}
+
+bool ArgParser::LoadSchemaFile(const std::string& path, std::uint64_t expected_hash) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    bool is_ok = LoadSchema(std::string_view(static_cast<const char*>(data), st.st_size),
+        expected_hash);
+    munmap(data, st.st_size);
+    return is_ok;
+}
+
+} // namespace ArgumentParser
@@ -0,0 +1,448 @@
+#include "SharedResult.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ArgumentParser {
+
+namespace {
+
+const char kResultMagic[8] = {'A', 'R', 'G', 'R', 'S', 'L', 'T', '\0'};
+// 2: is_multi in ResultRecord
+const std::uint32_t kResultVersion = 2;
+
+const std::uint8_t kRecordInt = 0;
+const std::uint8_t kRecordString = 1;
+const std::uint8_t kRecordBool = 2;
+
+// Same idea as the schema blob: fixed-size fields and offsets only, so
+// the image can be mapped at any address. Sections follow each other in
+// this order and all of them are 4-byte aligned:
+// header, records (sorted by name), int values, string refs, strings.
+struct ResultStringRef {
+    std::uint32_t offset;
+    std::uint32_t size;
+};
+
+struct ResultHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t record_count;
+    std::uint32_t ints_offset;
+    std::uint32_t int_count;
+    std::uint32_t refs_offset;
+    std::uint32_t ref_count;
+    std::uint32_t strings_offset;
+    std::uint32_t strings_size;
+    std::int32_t error_token_index;
+    std::uint8_t error_code;
+    std::uint8_t is_ok;
+    std::uint8_t help;
+    std::uint8_t reserved;
+};
+
+// first indexes the int values or the string refs, a flag keeps its
+// value there. Like ArgParser, a single-value record ignores the index
+// its value is asked for with.
+struct ResultRecord {
+    ResultStringRef name;
+    std::uint32_t first;
+    std::uint32_t count;
+    std::uint8_t type;
+    std::uint8_t is_set;
+    std::uint8_t is_multi;
+    std::uint8_t reserved;
+};
+
+template <typename T>
+T ReadAt(std::string_view blob, size_t offset) {
+    T ret;
+    std::memcpy(&ret, blob.data() + offset, sizeof(T));
+    return ret;
+}
+
+ResultStringRef AddString(std::string& strings, std::string_view val) {
+    ResultStringRef ref{static_cast<std::uint32_t>(strings.size()),
+        static_cast<std::uint32_t>(val.size())};
+    strings.append(val);
+    return ref;
+}
+
+template <typename T>
+void AppendSection(std::string& blob, const std::vector<T>& section) {
+    blob.append(reinterpret_cast<const char*>(section.data()), section.size() * sizeof(T));
+}
+
+} // namespace
+
+std::string ArgParser::SerializeResult() const {
+    std::vector<std::string_view> names;
+    names.reserve(name_to_argument_node_.size());
+    for (const auto& [param, ptr] : name_to_argument_node_) {
+        names.push_back(param);
+    }
+    std::sort(names.begin(), names.end());
+
+    ResultHeader header{};
+    std::memcpy(header.magic, kResultMagic, sizeof(kResultMagic));
+    header.version = kResultVersion;
+    header.error_code = static_cast<std::uint8_t>(parse_error_.code);
+    header.error_token_index = parse_error_.token_index;
+    header.is_ok = good_parse_;
+
+    std::vector<ResultRecord> records;
+    std::vector<std::int32_t> ints;
+    std::vector<ResultStringRef> refs;
+    std::string strings;
+    records.reserve(names.size());
+    for (std::string_view name : names) {
+        const Node& node = *name_to_argument_node_.find(name)->second;
+        ResultRecord record{};
+        switch (node.GetType()) {
+        case ArgType::kIntArg: {
+            const IntArg& arg = static_cast<const IntArg&>(node);
+            record.type = kRecordInt;
+            record.is_set = arg.IsInitialized();
+            record.is_multi = arg.IsMultiValue();
+            record.first = ints.size();
+            record.count = record.is_set ? arg.GetValueCount() : 0;
+            for (int i = 0; i < record.count; ++i) {
+                ints.push_back(*arg.TryGetIntValue(i));
+            }
+            break;
+        }
+        case ArgType::kStringArg: {
+            const StringArg& arg = static_cast<const StringArg&>(node);
+            record.type = kRecordString;
+            record.is_set = arg.IsInitialized();
+            record.is_multi = arg.IsMultiValue();
+            record.first = refs.size();
+            record.count = record.is_set ? arg.GetValueCount() : 0;
+            for (int i = 0; i < record.count; ++i) {
+                refs.push_back(AddString(strings, *arg.TryGetStringValue(i)));
+            }
+            break;
+        }
+        case ArgType::kIntSetArg: {
+            // Read back as an int list in ascending order
+            const IntSet& set = static_cast<const IntSetArg&>(node).GetSet();
+            record.type = kRecordInt;
+            record.is_set = true;
+            record.is_multi = true;
+            record.first = ints.size();
+            record.count = set.Size();
+            set.ForEach([&ints](int val) { ints.push_back(val); });
+            break;
+        }
+        case ArgType::kBoolArg:
+            record.type = kRecordBool;
+            record.is_set = true;
+            record.first = static_cast<const BoolArg&>(node).GetValue();
+            break;
+        case ArgType::kHelp:
+            header.help = node.IsUsed();
+            continue;
+        default:
+            continue;
+        }
+        record.name = AddString(strings, name);
+        records.push_back(record);
+    }
+
+    size_t blob_size = sizeof(ResultHeader) + records.size() * sizeof(ResultRecord) +
+        ints.size() * sizeof(std::int32_t) + refs.size() * sizeof(ResultStringRef) +
+        strings.size();
+    // Every offset and size in the blob is at most its size, so the 32-bit
+    // fields only wrap when the blob is too large
+    if (blob_size > UINT32_MAX) {
+        return {};
+    }
+    header.record_count = records.size();
+    header.ints_offset = sizeof(ResultHeader) + records.size() * sizeof(ResultRecord);
+    header.int_count = ints.size();
+    header.refs_offset = header.ints_offset + ints.size() * sizeof(std::int32_t);
+    header.ref_count = refs.size();
+    header.strings_offset = header.refs_offset + refs.size() * sizeof(ResultStringRef);
+    header.strings_size = strings.size();
+
+    std::string blob;
+    blob.reserve(blob_size);
+    blob.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    AppendSection(blob, records);
+    AppendSection(blob, ints);
+    AppendSection(blob, refs);
+    blob += strings;
+    return blob;
+}
+
+int ArgParser::ExportResult() const {
+    std::string blob = SerializeResult();
+    if (blob.empty()) {
+        return -1;
+    }
+    int fd = memfd_create("argparser-result", MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        return -1;
+    }
+    std::string_view rest = blob;
+    while (!rest.empty()) {
+        ssize_t written = write(fd, rest.data(), rest.size());
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0) {
+            close(fd);
+            return -1;
+        }
+        rest.remove_prefix(written);
+    }
+    // Workers get a segment nobody can change under them
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+struct ParseResult::Record {
+    std::uint32_t first;
+    std::uint32_t count;
+    bool is_set;
+    bool is_multi;
+};
+
+ParseResult::ParseResult(ParseResult&& other) noexcept {
+    *this = std::move(other);
+}
+
+ParseResult& ParseResult::operator=(ParseResult&& other) noexcept {
+    if (this != &other) {
+        Detach();
+        blob_ = other.blob_;
+        mapping_ = std::exchange(other.mapping_, nullptr);
+        mapping_size_ = std::exchange(other.mapping_size_, 0);
+        is_ok_ = other.is_ok_;
+        help_ = other.help_;
+        parse_error_ = other.parse_error_;
+        other.blob_ = {};
+    }
+    return *this;
+}
+
+ParseResult::~ParseResult() {
+    Detach();
+}
+
+void ParseResult::Detach() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+        mapping_size_ = 0;
+    }
+    blob_ = {};
+}
+
+bool ParseResult::Attach(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        return false;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    if (!Attach(std::string_view(static_cast<const char*>(data), st.st_size))) {
+        munmap(data, st.st_size);
+        return false;
+    }
+    mapping_ = data;
+    mapping_size_ = st.st_size;
+    return true;
+}
+
+bool ParseResult::Attach(std::string_view blob) {
+    Detach();
+    // Int values are handed out as spans, so they must be aligned
+    if (blob.size() < sizeof(ResultHeader) ||
+        reinterpret_cast<std::uintptr_t>(blob.data()) % alignof(std::int32_t) != 0)
+    {
+        return false;
+    }
+    ResultHeader header = ReadAt<ResultHeader>(blob, 0);
+    size_t records_end = sizeof(ResultHeader) +
+        static_cast<size_t>(header.record_count) * sizeof(ResultRecord);
+    size_t ints_end = header.ints_offset + static_cast<size_t>(header.int_count) * sizeof(std::int32_t);
+    size_t refs_end = header.refs_offset +
+        static_cast<size_t>(header.ref_count) * sizeof(ResultStringRef);
+    if (std::memcmp(header.magic, kResultMagic, sizeof(kResultMagic)) != 0 ||
+        header.version != kResultVersion ||
+        header.ints_offset != records_end || header.refs_offset != ints_end ||
+        header.strings_offset != refs_end ||
+        static_cast<size_t>(header.strings_offset) + header.strings_size != blob.size())
+    {
+        return false;
+    }
+    // Check every reference once here, accessors then trust the blob
+    auto is_valid_string = [&header](ResultStringRef ref) {
+        return ref.offset <= header.strings_size && ref.size <= header.strings_size - ref.offset;
+    };
+    for (std::uint32_t i = 0; i < header.record_count; ++i) {
+        ResultRecord record = ReadAt<ResultRecord>(blob,
+            sizeof(ResultHeader) + i * sizeof(ResultRecord));
+        std::uint32_t limit = record.type == kRecordInt ? header.int_count :
+            record.type == kRecordString ? header.ref_count : 0;
+        if (record.type > kRecordBool || !is_valid_string(record.name) ||
+            (record.type != kRecordBool &&
+                (record.first > limit || record.count > limit - record.first)))
+        {
+            return false;
+        }
+    }
+    for (std::uint32_t i = 0; i < header.ref_count; ++i) {
+        if (!is_valid_string(ReadAt<ResultStringRef>(blob,
+            header.refs_offset + i * sizeof(ResultStringRef))))
+        {
+            return false;
+        }
+    }
+    blob_ = blob;
+    is_ok_ = header.is_ok;
+    help_ = header.help;
+    parse_error_ = ParseError{static_cast<ErrorCode>(header.error_code), header.error_token_index};
+    return true;
+}
+
+std::expected<ParseResult::Record, ErrorCode> ParseResult::FindRecord(std::string_view param,
+    std::uint8_t type) const
+{
+    if (blob_.empty()) {
+        return std::unexpected(ErrorCode::kUnknownParam);
+    }
+    ResultHeader header = ReadAt<ResultHeader>(blob_, 0);
+    std::string_view strings = blob_.substr(header.strings_offset);
+    auto record_at = [this](std::uint32_t ind) {
+        return ReadAt<ResultRecord>(blob_, sizeof(ResultHeader) + ind * sizeof(ResultRecord));
+    };
+    // Records are sorted by name
+    std::uint32_t left = 0;
+    std::uint32_t right = header.record_count;
+    while (left < right) {
+        std::uint32_t mid = left + (right - left) / 2;
+        ResultRecord record = record_at(mid);
+        if (strings.substr(record.name.offset, record.name.size) < param) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    if (left == header.record_count) {
+        return std::unexpected(ErrorCode::kUnknownParam);
+    }
+    ResultRecord record = record_at(left);
+    if (strings.substr(record.name.offset, record.name.size) != param) {
+        return std::unexpected(ErrorCode::kUnknownParam);
+    }
+    if (record.type != type) {
+        return std::unexpected(ErrorCode::kTypeMismatch);
+    }
+    return Record{record.first, record.count, record.is_set != 0, record.is_multi != 0};
+}
+
+std::expected<std::span<const std::int32_t>, ErrorCode> ParseResult::TryGetIntValues(
+    const std::string& param) const
+{
+    auto record = FindRecord(param, kRecordInt);
+    if (!record) {
+        return std::unexpected(record.error());
+    }
+    if (!record->is_set) {
+        return std::unexpected(ErrorCode::kNotInitialized);
+    }
+    ResultHeader header = ReadAt<ResultHeader>(blob_, 0);
+    const auto* ints = reinterpret_cast<const std::int32_t*>(blob_.data() + header.ints_offset);
+    return std::span<const std::int32_t>(ints + record->first, record->count);
+}
+
+std::expected<int, ErrorCode> ParseResult::TryGetIntValue(const std::string& param,
+    int ind) const
+{
+    auto record = FindRecord(param, kRecordInt);
+    if (!record) {
+        return std::unexpected(record.error());
+    }
+    if (!record->is_set) {
+        return std::unexpected(ErrorCode::kNotInitialized);
+    }
+    if (!record->is_multi) {
+        ind = 0;
+    }
+    if (ind < 0 || ind >= record->count) {
+        return std::unexpected(ErrorCode::kIndexOutOfRange);
+    }
+    ResultHeader header = ReadAt<ResultHeader>(blob_, 0);
+    return ReadAt<std::int32_t>(blob_,
+        header.ints_offset + (record->first + ind) * sizeof(std::int32_t));
+}
+
+std::expected<std::string_view, ErrorCode> ParseResult::TryGetStringValue(
+    const std::string& param, int ind) const
+{
+    auto record = FindRecord(param, kRecordString);
+    if (!record) {
+        return std::unexpected(record.error());
+    }
+    if (!record->is_set) {
+        return std::unexpected(ErrorCode::kNotInitialized);
+    }
+    if (!record->is_multi) {
+        ind = 0;
+    }
+    if (ind < 0 || ind >= record->count) {
+        return std::unexpected(ErrorCode::kIndexOutOfRange);
+    }
+    ResultHeader header = ReadAt<ResultHeader>(blob_, 0);
+    ResultStringRef ref = ReadAt<ResultStringRef>(blob_,
+        header.refs_offset + (record->first + ind) * sizeof(ResultStringRef));
+    return blob_.substr(header.strings_offset + ref.offset, ref.size);
+}
+
+std::expected<bool, ErrorCode> ParseResult::TryGetFlag(const std::string& param) const {
+    auto record = FindRecord(param, kRecordBool);
+    if (!record) {
+        return std::unexpected(record.error());
+    }
+    return record->first != 0;
+}
+
+int ParseResult::GetIntValue(const std::string& param, int ind) const {
+    auto value = TryGetIntValue(param, ind);
+    if (!value) {
+        throw std::runtime_error(std::string(ToString(value.error())) + ": " + param);
+    }
+    return *value;
+}
+
+std::string ParseResult::GetStringValue(const std::string& param, int ind) const {
+    auto value = TryGetStringValue(param, ind);
+    if (!value) {
+        throw std::runtime_error(std::string(ToString(value.error())) + ": " + param);
+    }
+    return std::string(*value);
+}
+
+bool ParseResult::GetFlag(const std::string& param) const {
+    auto value = TryGetFlag(param);
+    if (!value) {
+        throw std::runtime_error(std::string(ToString(value.error())) + ": " + param);
+    }
+    return *value;
+}
+
+} // namespace ArgumentParser
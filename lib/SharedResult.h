@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "ArgParser.h"
+
+namespace ArgumentParser {
+
+// Read-only view of a parse result exported by ArgParser::SerializeResult
+// or ArgParser::ExportResult. Accessors behave like the ArgParser ones;
+// every value is read in place, so workers attached to one memfd share a
+// single copy of large MultiValue lists.
+class ParseResult {
+ public:
+    ParseResult() = default;
+    ParseResult(const ParseResult&) = delete;
+    ParseResult& operator=(const ParseResult&) = delete;
+    ParseResult(ParseResult&& other) noexcept;
+    ParseResult& operator=(ParseResult&& other) noexcept;
+    ~ParseResult();
+
+    // Maps the segment read-only; fd may be closed right after
+    bool Attach(int fd);
+    // Uses blob in place, it must outlive the result
+    bool Attach(std::string_view blob);
+
+    // What Parse returned, whether help was requested and the first error
+    bool IsOk() const { return is_ok_; }
+    bool Help() const { return help_; }
+    const ParseError& GetParseError() const { return parse_error_; }
+
+    std::string GetStringValue(const std::string& param, int ind = 0) const;
+    bool GetFlag(const std::string& param) const;
+    int GetIntValue(const std::string& param, int ind = 0) const;
+
+    std::expected<int, ErrorCode> TryGetIntValue(const std::string& param, int ind = 0) const;
+    std::expected<std::string_view, ErrorCode> TryGetStringValue(const std::string& param,
+        int ind = 0) const;
+    std::expected<bool, ErrorCode> TryGetFlag(const std::string& param) const;
+    // Every value of an int argument, without copying
+    std::expected<std::span<const std::int32_t>, ErrorCode> TryGetIntValues(
+        const std::string& param) const;
+
+ private:
+    struct Record;
+
+    std::expected<Record, ErrorCode> FindRecord(std::string_view param,
+        std::uint8_t type) const;
+    void Detach();
+
+    std::string_view blob_;
+    void* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    bool is_ok_ = false;
+    bool help_ = false;
+    ParseError parse_error_;
+};
+
+} // namespace ArgumentParser
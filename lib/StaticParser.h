@@ -0,0 +1,490 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "ArgParser.h"
+
+namespace ArgumentParser {
+
+/*
+    Compile-time counterpart of ArgParser for schemas that are fixed at
+    build time. Arguments are described by types:
+
+    using Cli = StaticParser<
+        StaticFlag<"verbose", 'v'>,
+        StaticInt<"port", 'p', 8080>,
+        StaticString<"host">,
+        StaticPositional<StaticMultiValue<StaticInt<"N">>>>;
+
+    Cli cli;
+    cli.Parse(argc, argv);
+    int port = cli.Get<"port">();
+
+    Values live in a std::tuple, names are dispatched through a table built
+    by the compiler and every Get is checked at compile time. The command
+    line grammar and the requirements (an argument without a default must
+    be given, multi-value ones need MinSize values) match ArgParser::Parse.
+*/
+
+// String literal usable as a template argument
+template <size_t N>
+struct FixedString {
+    char data[N] = {};
+
+    constexpr FixedString(const char (&str)[N]) {
+        std::copy_n(str, N, data);
+    }
+
+    constexpr std::string_view View() const {
+        return std::string_view(data, N - 1);
+    }
+};
+
+template <FixedString Name, char FlagChar = '\0', bool Default = false>
+struct StaticFlag {
+    using ValueType = bool;
+    constexpr static std::string_view kName = Name.View();
+    constexpr static char kFlag = FlagChar;
+    constexpr static bool kTakesArgument = false;
+    constexpr static bool kHasDefault = true;
+    constexpr static bool kMultiValue = false;
+    constexpr static bool kPositional = false;
+
+    static void Reset(bool& value) { value = Default; }
+    static void Called(bool& value) { value = true; }
+    static bool AddValue(bool&, std::string_view) { return false; }
+    static bool IsOk(const bool&, bool) { return true; }
+};
+
+// Int without a default value is required
+template <FixedString Name, char FlagChar = '\0', int... Default>
+struct StaticInt {
+    static_assert(sizeof...(Default) <= 1, "StaticInt takes at most one default value");
+
+    using ValueType = int;
+    constexpr static std::string_view kName = Name.View();
+    constexpr static char kFlag = FlagChar;
+    constexpr static bool kTakesArgument = true;
+    constexpr static bool kHasDefault = sizeof...(Default) == 1;
+    constexpr static bool kMultiValue = false;
+    constexpr static bool kPositional = false;
+
+    static void Reset(int& value) { value = (0 + ... + Default); }
+    static void Called(int&) {}
+
+    // Same rules as ArgParser: optional '-' and digits only, within int
+    static bool AddValue(int& value, std::string_view val) {
+        if (val.empty() || val[0] == '+') {
+            return false;
+        }
+        auto [end, error] = std::from_chars(val.data(), val.data() + val.size(), value);
+        return error == std::errc() && end == val.data() + val.size();
+    }
+
+    static bool IsOk(const int&, bool is_used) { return kHasDefault || is_used; }
+};
+
+// String without a default value is required
+template <FixedString Name, char FlagChar = '\0', FixedString... Default>
+struct StaticString {
+    static_assert(sizeof...(Default) <= 1, "StaticString takes at most one default value");
+
+    using ValueType = std::string;
+    constexpr static std::string_view kName = Name.View();
+    constexpr static char kFlag = FlagChar;
+    constexpr static bool kTakesArgument = true;
+    constexpr static bool kHasDefault = sizeof...(Default) == 1;
+    constexpr static bool kMultiValue = false;
+    constexpr static bool kPositional = false;
+
+    static void Reset(std::string& value) {
+        value.clear();
+        (value.append(Default.View()), ...);
+    }
+
+    static void Called(std::string&) {}
+
+    static bool AddValue(std::string& value, std::string_view val) {
+        value.assign(val);
+        return true;
+    }
+
+    static bool IsOk(const std::string&, bool is_used) { return kHasDefault || is_used; }
+};
+
+// Collects every value of Arg into a std::vector
+template <typename Arg, size_t MinSize = 1>
+struct StaticMultiValue {
+    static_assert(Arg::kTakesArgument && !Arg::kMultiValue,
+        "StaticMultiValue needs a single-value StaticInt or StaticString");
+
+    using ValueType = std::vector<typename Arg::ValueType>;
+    constexpr static std::string_view kName = Arg::kName;
+    constexpr static char kFlag = Arg::kFlag;
+    constexpr static bool kTakesArgument = true;
+    constexpr static bool kHasDefault = Arg::kHasDefault;
+    constexpr static bool kMultiValue = true;
+    constexpr static bool kPositional = Arg::kPositional;
+
+    // clear() keeps the capacity for the next parse
+    static void Reset(ValueType& values) { values.clear(); }
+    static void Called(ValueType&) {}
+
+    static bool AddValue(ValueType& values, std::string_view val) {
+        typename Arg::ValueType value;
+        if (!Arg::AddValue(value, val)) {
+            return false;
+        }
+        values.push_back(std::move(value));
+        return true;
+    }
+
+    static bool IsOk(const ValueType& values, bool) {
+        return kHasDefault || values.size() >= MinSize;
+    }
+};
+
+// Receives the values that do not belong to any option
+template <typename Arg>
+struct StaticPositional : Arg {
+    static_assert(Arg::kTakesArgument, "Only StaticInt and StaticString can be positional");
+
+    constexpr static bool kPositional = true;
+};
+
+template <typename... Args>
+class StaticParser {
+    constexpr static size_t kSize = sizeof...(Args);
+    constexpr static std::uint8_t kNoSlot = 0xff;
+    constexpr static size_t kTableSize = std::bit_ceil(std::max<size_t>(4 * kSize, 1));
+    constexpr static std::uint64_t kMaxPerfectSeed = 1 << 12;
+    constexpr static std::string_view kEndOfOptions = "--";
+
+    static_assert(kSize < kNoSlot, "StaticParser supports up to 254 arguments");
+
+    template <size_t I>
+    using ArgAt = std::tuple_element_t<I, std::tuple<Args...>>;
+
+    constexpr static std::array<std::string_view, kSize> kNames = {Args::kName...};
+
+    constexpr static size_t IndexOf(std::string_view name) {
+        for (size_t i = 0; i < kSize; ++i) {
+            if (kNames[i] == name) {
+                return i;
+            }
+        }
+        return kSize;
+    }
+
+    constexpr static bool NamesAreUnique() {
+        for (size_t i = 0; i < kSize; ++i) {
+            if (kNames[i].empty() || IndexOf(kNames[i]) != i) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(NamesAreUnique(), "Argument names must be non-empty and unique");
+
+    constexpr static size_t kPositionalIndex = [] {
+        size_t ret = kSize;
+        size_t count = 0;
+        constexpr std::array<bool, kSize> is_positional = {Args::kPositional...};
+        for (size_t i = 0; i < kSize; ++i) {
+            if (is_positional[i]) {
+                ret = i;
+                ++count;
+            }
+        }
+        return count <= 1 ? ret : kSize + 1;
+    }();
+
+    static_assert(kPositionalIndex <= kSize, "Positional argument could be only one");
+
+    constexpr static std::array<std::uint8_t, 256> kFlagTable = [] {
+        std::array<std::uint8_t, 256> table{};
+        table.fill(kNoSlot);
+        constexpr std::array<char, kSize> flags = {Args::kFlag...};
+        for (size_t i = 0; i < kSize; ++i) {
+            if (flags[i] != '\0') {
+                table[static_cast<unsigned char>(flags[i])] =
+                    table[static_cast<unsigned char>(flags[i])] == kNoSlot ? i : kSize;
+            }
+        }
+        return table;
+    }();
+
+    constexpr static bool FlagsAreUnique() {
+        return std::find(kFlagTable.begin(), kFlagTable.end(), kSize) == kFlagTable.end();
+    }
+
+    static_assert(FlagsAreUnique(), "Argument flags must be unique");
+
+    constexpr static size_t Slot(std::string_view name, std::uint64_t seed) {
+        std::uint64_t hash = 14695981039346656037ull ^ seed;
+        for (unsigned char c : name) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return (hash ^ (hash >> 32)) & (kTableSize - 1);
+    }
+
+    struct NameTable {
+        std::uint64_t seed = 0;
+        std::array<std::uint8_t, kTableSize> slots{};
+    };
+
+    // Looks for a seed that gives every name its own slot, so a lookup is
+    // one hash and one comparison. Large schemas may not get one within
+    // kMaxPerfectSeed tries and fall back to linear probing.
+    constexpr static NameTable kNameTable = [] {
+        NameTable table;
+        for (std::uint64_t seed = 0; seed < kMaxPerfectSeed; ++seed) {
+            table.seed = seed;
+            table.slots.fill(kNoSlot);
+            bool is_perfect = true;
+            for (size_t i = 0; i < kSize && is_perfect; ++i) {
+                size_t slot = Slot(kNames[i], seed);
+                is_perfect = table.slots[slot] == kNoSlot;
+                table.slots[slot] = i;
+            }
+            if (is_perfect) {
+                return table;
+            }
+        }
+        table.seed = 0;
+        table.slots.fill(kNoSlot);
+        for (size_t i = 0; i < kSize; ++i) {
+            size_t slot = Slot(kNames[i], 0);
+            while (table.slots[slot] != kNoSlot) {
+                slot = (slot + 1) & (kTableSize - 1);
+            }
+            table.slots[slot] = i;
+        }
+        return table;
+    }();
+
+ public:
+    constexpr static std::uint8_t FindName(std::string_view name) {
+        size_t slot = Slot(name, kNameTable.seed);
+        while (kNameTable.slots[slot] != kNoSlot) {
+            if (kNames[kNameTable.slots[slot]] == name) {
+                return kNameTable.slots[slot];
+            }
+            slot = (slot + 1) & (kTableSize - 1);
+        }
+        return kNoSlot;
+    }
+
+    constexpr static std::uint8_t FindFlag(char flag) {
+        return kFlagTable[static_cast<unsigned char>(flag)];
+    }
+
+    StaticParser() {
+        ResetValues();
+    }
+
+    // args[0] stands for program name
+    bool Parse(const std::vector<std::string>& args) {
+        return ParseTokens(args);
+    }
+
+    bool Parse(const int argc, char** argv) {
+        return ParseTokens(std::span<char* const>(argv, argc));
+    }
+
+    template <FixedString Name>
+    const auto& Get() const {
+        constexpr size_t kIndex = IndexOf(Name.View());
+        static_assert(kIndex < kSize, "Unknown argument name");
+        return std::get<kIndex>(values_);
+    }
+
+    template <FixedString Name>
+    bool IsUsed() const {
+        constexpr size_t kIndex = IndexOf(Name.View());
+        static_assert(kIndex < kSize, "Unknown argument name");
+        return is_used_[kIndex];
+    }
+
+    const ParseError& GetParseError() const {
+        return parse_error_;
+    }
+
+ private:
+    // Calls func(std::integral_constant<size_t, I>) for I == ind; the
+    // fold over the index sequence compiles to a jump table
+    template <typename Func>
+    static void Visit(size_t ind, Func&& func) {
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            ((ind == I ? (func(std::integral_constant<size_t, I>{}), true) : false) || ...);
+        }(std::index_sequence_for<Args...>{});
+    }
+
+    void ResetValues() {
+        [this]<size_t... I>(std::index_sequence<I...>) {
+            (ArgAt<I>::Reset(std::get<I>(values_)), ...);
+        }(std::index_sequence_for<Args...>{});
+        is_used_.fill(false);
+        parse_error_ = ParseError{};
+    }
+
+    void SetParseError(ErrorCode code, int token_index) {
+        if (parse_error_.code == ErrorCode::kOk) {
+            parse_error_ = ParseError{code, token_index};
+        }
+    }
+
+    // Like ArgParser, an option that takes an argument counts as used
+    // only once it gets a value
+    void Called(size_t ind) {
+        is_used_[ind] = is_used_[ind] || !TakesArgument(ind);
+        Visit(ind, [this]<size_t I>(std::integral_constant<size_t, I>) {
+            ArgAt<I>::Called(std::get<I>(values_));
+        });
+    }
+
+    static constexpr bool TakesArgument(size_t ind) {
+        constexpr std::array<bool, kSize> takes = {Args::kTakesArgument...};
+        return takes[ind];
+    }
+
+    static constexpr bool IsMultiValue(size_t ind) {
+        constexpr std::array<bool, kSize> multi = {Args::kMultiValue...};
+        return multi[ind];
+    }
+
+    bool AddValue(size_t ind, std::string_view val) {
+        bool is_ok = false;
+        Visit(ind, [&]<size_t I>(std::integral_constant<size_t, I>) {
+            is_ok = ArgAt<I>::AddValue(std::get<I>(values_), val);
+        });
+        is_used_[ind] = is_used_[ind] || is_ok;
+        return is_ok;
+    }
+
+    // Mirrors ArgParser::ProcessValue: a value goes to the current option
+    // while it still awaits one, otherwise to the positional argument
+    bool ProcessValue(std::string_view val, int token_index) {
+        bool to_positional = cur_ind_ == kNoSlot || !TakesArgument(cur_ind_) ||
+            (!IsMultiValue(cur_ind_) && cur_got_arg_);
+        cur_got_arg_ = true;
+        if (to_positional && kPositionalIndex == kSize) {
+            SetParseError(ErrorCode::kNoPositional, token_index);
+            return false;
+        }
+        if (!AddValue(to_positional ? kPositionalIndex : cur_ind_, val)) {
+            SetParseError(ErrorCode::kInvalidValue, token_index);
+            return false;
+        }
+        return true;
+    }
+
+    // "-abc" or "-abc=value" when every char before '=' is a known flag
+    bool ProcessFlags(std::string_view token, int token_index) {
+        size_t end = std::min(token.find('='), token.size());
+        for (size_t i = 1; i < end; ++i) {
+            cur_ind_ = FindFlag(token[i]);
+            cur_got_arg_ = false;
+            Called(cur_ind_);
+        }
+        if (end + 1 < token.size()) {
+            return ProcessValue(token.substr(end + 1), token_index);
+        }
+        return true;
+    }
+
+    bool IsFlagCluster(std::string_view token) const {
+        size_t end = std::min(token.find('='), token.size());
+        if (end < 2) {
+            return false;
+        }
+        for (size_t i = 1; i < end; ++i) {
+            if (FindFlag(token[i]) == kNoSlot) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ProcessArgument(std::string_view token, int token_index) {
+        size_t end = std::min(token.find('='), token.size());
+        std::uint8_t ind = FindName(token.substr(2, end - 2));
+        if (ind == kNoSlot) {
+            SetParseError(ErrorCode::kUnknownArgument, token_index);
+            cur_ind_ = kNoSlot;
+            cur_got_arg_ = false;
+            return false;
+        }
+        cur_ind_ = ind;
+        cur_got_arg_ = false;
+        Called(ind);
+        // As in ArgParser, "--name=" takes its value from the next token
+        if (end + 1 < token.size()) {
+            return ProcessValue(token.substr(end + 1), token_index);
+        }
+        return true;
+    }
+
+    bool AwaitsValue() const {
+        return cur_ind_ != kNoSlot && TakesArgument(cur_ind_) && !cur_got_arg_;
+    }
+
+    template <typename Tokens>
+    bool ParseTokens(const Tokens& args) {
+        ResetValues();
+        cur_ind_ = kNoSlot;
+        cur_got_arg_ = false;
+        bool good_parse = true;
+        for (size_t i = 1; i < args.size(); ++i) {
+            std::string_view token = args[i];
+            if (token.empty()) {
+                continue;
+            }
+            if (token == kEndOfOptions && !AwaitsValue()) {
+                for (size_t j = i + 1; j < args.size(); ++j) {
+                    cur_ind_ = kNoSlot;
+                    good_parse &= ProcessValue(args[j], j);
+                }
+                break;
+            }
+            // "--" that an option still awaits is its value, as in ArgParser
+            if (token == "-" || token == kEndOfOptions || token[0] != '-') {
+                good_parse &= ProcessValue(token, i);
+            } else if (token[1] != '-') {
+                good_parse &= IsFlagCluster(token) ?
+                    ProcessFlags(token, i) : ProcessValue(token, i);
+            } else {
+                good_parse &= ProcessArgument(token, i);
+            }
+        }
+        bool is_ok = true;
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            is_ok = (ArgAt<I>::IsOk(std::get<I>(values_), is_used_[I]) && ...);
+        }(std::index_sequence_for<Args...>{});
+        if (!is_ok) {
+            SetParseError(ErrorCode::kMissingArgument, -1);
+            good_parse = false;
+        }
+        return good_parse;
+    }
+
+    std::tuple<typename Args::ValueType...> values_;
+    std::array<bool, kSize> is_used_{};
+    ParseError parse_error_;
+    std::uint8_t cur_ind_ = kNoSlot;
+    bool cur_got_arg_ = false;
+};
+
+} // namespace ArgumentParser
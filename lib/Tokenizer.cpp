@@ -0,0 +1,119 @@
+#include "Tokenizer.h"
+
+#include "MemoryReport.h"
+
+namespace ArgumentParser {
+
+namespace {
+
+bool IsBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\n';
+}
+
+bool IsQuoting(char c) {
+    return c == '\'' || c == '"' || c == '\\';
+}
+
+// Inside double quotes a backslash only escapes these
+bool IsEscapedInDoubleQuotes(char c) {
+    return c == '$' || c == '`' || c == '"' || c == '\\' || c == '\n';
+}
+
+} // namespace
+
+bool CommandLineTokenizer::Tokenize(std::string_view line) {
+    tokens_.clear();
+    arena_.clear();
+    size_t pos = 0;
+    while (true) {
+        while (pos < line.size()) {
+            if (IsBlank(line[pos])) {
+                ++pos;
+            } else if (line.substr(pos, 2) == "\\\n") {
+                pos += 2;
+            } else {
+                break;
+            }
+        }
+        if (pos == line.size()) {
+            return true;
+        }
+        if (line[pos] == '#') {
+            pos = line.find('\n', pos);
+            if (pos == std::string_view::npos) {
+                return true;
+            }
+            continue;
+        }
+        size_t start = pos;
+        while (pos < line.size() && !IsBlank(line[pos]) && !IsQuoting(line[pos])) {
+            ++pos;
+        }
+        if (pos == line.size() || IsBlank(line[pos])) {
+            tokens_.push_back(line.substr(start, pos - start));
+            continue;
+        }
+        // Every unescaped char comes from at least one input char, so one
+        // reservation keeps the views into the arena valid
+        if (arena_.capacity() < line.size()) {
+            arena_.reserve(line.size());
+        }
+        size_t arena_start = arena_.size();
+        arena_.append(line.substr(start, pos - start));
+        if (!AppendQuoted(line, pos)) {
+            return false;
+        }
+        tokens_.emplace_back(arena_.data() + arena_start, arena_.size() - arena_start);
+    }
+}
+
+// Unescapes the rest of the word that starts before pos into the arena
+bool CommandLineTokenizer::AppendQuoted(std::string_view line, size_t& pos) {
+    while (pos < line.size() && !IsBlank(line[pos])) {
+        char c = line[pos];
+        if (c == '\'') {
+            size_t end = line.find('\'', pos + 1);
+            if (end == std::string_view::npos) {
+                return false;
+            }
+            arena_.append(line.substr(pos + 1, end - pos - 1));
+            pos = end + 1;
+        } else if (c == '"') {
+            ++pos;
+            while (pos < line.size() && line[pos] != '"') {
+                if (line[pos] == '\\' && pos + 1 < line.size() &&
+                    IsEscapedInDoubleQuotes(line[pos + 1]))
+                {
+                    if (line[pos + 1] != '\n') {
+                        arena_ += line[pos + 1];
+                    }
+                    pos += 2;
+                } else {
+                    arena_ += line[pos++];
+                }
+            }
+            if (pos == line.size()) {
+                return false;
+            }
+            ++pos;
+        } else if (c == '\\') {
+            if (pos + 1 == line.size()) {
+                return false;
+            }
+            if (line[pos + 1] != '\n') {
+                arena_ += line[pos + 1];
+            }
+            pos += 2;
+        } else {
+            arena_ += c;
+            ++pos;
+        }
+    }
+    return true;
+}
+
+size_t CommandLineTokenizer::HeapBytes() const {
+    return VectorBytes(tokens_) + StringBytes(arena_);
+}
+
+} // namespace ArgumentParser
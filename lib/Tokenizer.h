@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ArgumentParser {
+
+// Splits a command line into words the way a POSIX shell does, without
+// any expansion: blanks separate words, '...' and "..." quote, backslash
+// escapes, and '#' at the start of a word begins a comment. Words that
+// contain no quoting are views into the input; the others are unescaped
+// into an arena owned by the tokenizer. Both stay valid until the next
+// Tokenize call (and as long as the input does).
+class CommandLineTokenizer {
+ public:
+    // Returns false on an unterminated quote or a trailing backslash;
+    // Tokens() then holds the words before the broken one
+    bool Tokenize(std::string_view line);
+    const std::vector<std::string_view>& Tokens() const { return tokens_; }
+    size_t HeapBytes() const;
+
+ private:
+    bool AppendQuoted(std::string_view line, size_t& pos);
+
+    std::vector<std::string_view> tokens_;
+    std::string arena_;
+};
+
+} // namespace ArgumentParser
@@ -0,0 +1,89 @@
+#include "Utf8.h"
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace ArgumentParser {
+
+namespace {
+
+// Length of the ASCII run at the start of [first, last), rounded down to
+// whole blocks; the caller handles the tail byte by byte
+size_t AsciiPrefix(const unsigned char* first, const unsigned char* last) {
+    const unsigned char* cur = first;
+#ifdef __SSE2__
+    while (last - cur >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur));
+        if (_mm_movemask_epi8(block) != 0) {
+            return cur - first;
+        }
+        cur += 16;
+    }
+#endif
+    while (last - cur >= 8) {
+        std::uint64_t block;
+        std::memcpy(&block, cur, sizeof(block));
+        if ((block & 0x8080808080808080ull) != 0) {
+            return cur - first;
+        }
+        cur += 8;
+    }
+    return cur - first;
+}
+
+bool IsContinuation(unsigned char c) {
+    return (c & 0xC0) == 0x80;
+}
+
+} // namespace
+
+bool IsValidUtf8(std::string_view val) {
+    const unsigned char* cur = reinterpret_cast<const unsigned char*>(val.data());
+    const unsigned char* last = cur + val.size();
+    while (cur != last) {
+        cur += AsciiPrefix(cur, last);
+        if (cur == last) {
+            break;
+        }
+        unsigned char lead = *cur;
+        if (lead < 0x80) {
+            ++cur;
+            continue;
+        }
+        // Scalar path, one sequence at a time. Bounds of the second byte
+        // narrow down overlong forms, surrogates and code points above
+        // U+10FFFF (Unicode table 3-7)
+        size_t size = 0;
+        unsigned char lo = 0x80;
+        unsigned char hi = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            size = 2;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            size = 3;
+            if (lead == 0xE0) lo = 0xA0;
+            if (lead == 0xED) hi = 0x9F;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            size = 4;
+            if (lead == 0xF0) lo = 0x90;
+            if (lead == 0xF4) hi = 0x8F;
+        } else {
+            return false;
+        }
+        if (static_cast<size_t>(last - cur) < size || cur[1] < lo || cur[1] > hi) {
+            return false;
+        }
+        for (size_t i = 2; i < size; ++i) {
+            if (!IsContinuation(cur[i])) {
+                return false;
+            }
+        }
+        cur += size;
+    }
+    return true;
+}
+
+} // namespace ArgumentParser
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string_view>
+
+namespace ArgumentParser {
+
+// Checks that val is well-formed UTF-8 as defined by RFC 3629: no overlong
+// forms, no surrogates, nothing above U+10FFFF. Only runs of ASCII are
+// vectorized: they are skipped a vector register (or a machine word) at a
+// time, while every multi-byte sequence is decoded on its own, so mostly
+// non-ASCII text is checked at scalar speed.
+bool IsValidUtf8(std::string_view val);
+
+} // namespace ArgumentParser
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/*
+    Replaces global operator new with a counting one. Replacements must
+    not be inline, so include this header in exactly one translation unit
+    of a binary (argparser_alloc_tests and argparser_bench).
+*/
+
+namespace AllocationCounter {
+
+inline std::atomic<size_t> allocation_count = 0;
+
+// Allocations made by the whole process so far
+inline size_t Count() {
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+} // namespace AllocationCounter
+
+void* operator new(size_t size) {
+    AllocationCounter::allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
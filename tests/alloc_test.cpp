@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <lib/ArgParser.h>
+#include <tests/AllocationCounter.h>
+
+using namespace ArgumentParser;
+
+/*
+    Allocation budgets of the parse path. Global operator new is replaced
+    in this binary only (see AllocationCounter.h), so every scenario counts
+    what one Parse call on a warmed parser allocates.
+*/
+
+namespace {
+
+// Parses args twice and returns the number of allocations made by the
+// second call
+size_t WarmParseAllocations(ArgParser& parser, const std::vector<std::string>& args) {
+    EXPECT_TRUE(parser.Parse(args));
+    size_t before = AllocationCounter::Count();
+    EXPECT_TRUE(parser.Parse(args));
+    return AllocationCounter::Count() - before;
+}
+
+} // namespace
+
+
+TEST(ArgParserAllocTestSuite, FlagsTest) {
+    ArgParser parser("My Parser");
+    parser.AddFlag('a', "flag1");
+    parser.AddFlag('b', "flag2").Default(true);
+    parser.AddFlag('c', "flag3");
+
+    ASSERT_EQ(WarmParseAllocations(parser, {"app", "-ac", "--flag2", "-b"}), 0);
+}
+
+
+TEST(ArgParserAllocTestSuite, IntArgumentsTest) {
+    ArgParser parser("My Parser");
+    int value;
+    parser.AddIntArgument('n', "number").StoreValue(value);
+    parser.AddIntArgument("other").MultiValue();
+
+    ASSERT_EQ(WarmParseAllocations(parser,
+        {"app", "--number=10", "--other", "1", "--other=2", "-n", "3"}), 0);
+}
+
+
+TEST(ArgParserAllocTestSuite, PositionalTest) {
+    ArgParser parser("My Parser");
+    std::vector<int> values;
+    parser.AddIntArgument("Param1").MultiValue(1).Positional().StoreValues(values);
+    parser.AddFlag('s', "sum");
+
+    ASSERT_EQ(WarmParseAllocations(parser, {"app", "1", "2", "-s", "3", "--", "4", "5"}), 0);
+}
+
+
+TEST(ArgParserAllocTestSuite, CommandLineTest) {
+    ArgParser parser("My Parser");
+    std::vector<int> values;
+    parser.AddIntArgument("Param1").MultiValue(1).Positional().StoreValues(values);
+    parser.AddFlag('s', "sum");
+    std::string line = "app 1 '2' -s \\3 --sum \"4\" -- 5";
+
+    ASSERT_TRUE(parser.ParseCommandLine(line));
+    size_t before = AllocationCounter::Count();
+    ASSERT_TRUE(parser.ParseCommandLine(line));
+    ASSERT_EQ(AllocationCounter::Count() - before, 0);
+}
+
+
+TEST(ArgParserAllocTestSuite, LongStringsTest) {
+    ArgParser parser("My Parser");
+    parser.AddStringArgument("paths").MultiValue().Positional();
+    std::vector<std::string> args = {"app"};
+    for (int i = 0; i < 8; ++i) {
+        args.push_back("/a/path/long/enough/to/skip/the/small/string/buffer/" + std::to_string(i));
+    }
+
+    // Stored values own their text, nothing else allocates
+    ASSERT_EQ(WarmParseAllocations(parser, args), args.size() - 1);
+}
+
+
+TEST(ArgParserAllocTestSuite, LiteralRegistrationTest) {
+    ArgParser parser("My Parser");
+    // Sizes the name map and the touched list, so the measured calls
+    // below do not grow them
+    parser.AddFlag("first");
+    parser.AddFlag("second");
+    parser.AddFlag("third");
+    ASSERT_TRUE(parser.Parse({"app"}));
+    std::string name = "a-parameter-name-longer-than-the-small-buffer";
+    std::string description = "a description longer than the small string buffer";
+
+    size_t before = AllocationCounter::Count();
+    parser.AddIntArgument('n', Literal("a-literal-name-longer-than-the-small-buffer"),
+        Literal("a literal description longer than the small string buffer"));
+    size_t literal = AllocationCounter::Count() - before;
+
+    before = AllocationCounter::Count();
+    parser.AddIntArgument('m', name, description);
+    size_t copied = AllocationCounter::Count() - before;
+
+    // Only the node and its map entry; copies add one buffer per string
+    ASSERT_EQ(literal, 2);
+    ASSERT_EQ(copied, literal + 2);
+}
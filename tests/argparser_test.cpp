@@ -1,8 +1,14 @@
 #include <sstream>
 #include <fstream>
 
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include <gtest/gtest.h>
 #include <lib/ArgParser.h>
+#include <lib/SharedResult.h>
+#include <lib/StaticParser.h>
+#include <lib/Utf8.h>
 
 using namespace ArgumentParser;
 
@@ -219,3 +225,889 @@ TEST(ArgParserTestSuite, HelpStringTest) {
     //     "-h, --help Display this help and exit\n"
     // );
 }
+
+
+TEST(ArgParserTestSuite, SchemaRoundTripTest) {
+    ArgParser source("My Parser");
+    source.AddHelp('h', "help", "Some Description about program");
+    source.AddStringArgument('i', "input", "File path for input file").Default("in.txt");
+    source.AddFlag('s', "flag1", "Use some logic").Default(true);
+    source.AddIntArgument("Param1").MultiValue(2).Positional();
+
+    std::string path = testing::TempDir() + "argparser_schema.bin";
+    ASSERT_TRUE(source.SaveSchema(path));
+
+    ArgParser parser("My Parser");
+    ASSERT_TRUE(parser.LoadSchemaFile(path, source.SchemaHash()));
+    ASSERT_EQ(parser.SchemaHash(), source.SchemaHash());
+
+    ASSERT_TRUE(parser.Parse(SplitString("app 1 2 3")));
+    ASSERT_EQ(parser.GetStringValue("input"), "in.txt");
+    ASSERT_TRUE(parser.GetFlag("flag1"));
+    ASSERT_EQ(parser.GetIntValue("Param1", 2), 3);
+    ASSERT_FALSE(parser.Parse(SplitString("app 1")));
+}
+
+
+TEST(ArgParserTestSuite, SchemaOrderTest) {
+    // Registered out of alphabetical order
+    ArgParser source("My Parser");
+    source.AddFlag('z', "zeta", "Last by name");
+    source.AddIntArgument('m', "mid", "Required, registered first");
+    source.AddStringArgument('a', "alpha", "Required, registered last");
+    source.AddHelp('h', "help", "Some Description about program");
+    std::string blob = source.SerializeSchema();
+
+    ArgParser parser("My Parser");
+    ASSERT_TRUE(parser.LoadSchema(blob, source.SchemaHash()));
+    ASSERT_EQ(parser.SchemaHash(), source.SchemaHash());
+    ASSERT_EQ(parser.HelpDescription(), source.HelpDescription());
+
+    ASSERT_FALSE(source.Parse(SplitString("app -z")));
+    ASSERT_FALSE(parser.Parse(SplitString("app -z")));
+    ASSERT_EQ(parser.GetErrorMessage(), source.GetErrorMessage());
+}
+
+
+TEST(ArgParserTestSuite, StaleSchemaTest) {
+    ArgParser source("My Parser");
+    source.AddIntArgument('n', "number", "Some Number");
+    std::string blob = source.SerializeSchema();
+    std::uint64_t hash = source.SchemaHash();
+
+    source.AddFlag('f', "flag", "Flag");
+    ArgParser parser("My Parser");
+    ASSERT_FALSE(parser.LoadSchema(blob, source.SchemaHash()));
+
+    blob.back() ^= 1;
+    ASSERT_FALSE(parser.LoadSchema(blob, hash));
+}
+
+
+TEST(ArgParserTestSuite, SchemaUnsupportedTest) {
+    // Nothing that the blob cannot hold is dropped silently
+    ArgParser with_set("My Parser");
+    with_set.AddIntArgument('n', "number");
+    with_set.AddIntSetArgument('c', "cores");
+    ASSERT_THROW(with_set.SerializeSchema(), std::runtime_error);
+    ASSERT_THROW(with_set.SchemaHash(), std::runtime_error);
+
+    ArgParser with_range("My Parser");
+    with_range.AddIntArgument('n', "number").Range(0, 10);
+    ASSERT_THROW(with_range.SerializeSchema(), std::runtime_error);
+    ASSERT_THROW(with_range.SchemaHash(), std::runtime_error);
+
+    ArgParser with_choices("My Parser");
+    with_choices.AddStringArgument('m', "mode").Choices({"fast", "slow"});
+    ASSERT_THROW(with_choices.SerializeSchema(), std::runtime_error);
+
+    ArgParser with_subcommand("My Parser");
+    with_subcommand.AddSubcommand("build", [](ArgParser& sub) {});
+    ASSERT_THROW(with_subcommand.SchemaHash(), std::runtime_error);
+}
+
+
+TEST(ArgParserTestSuite, SubcommandTest) {
+    ArgParser parser("tool");
+    int built = 0;
+    parser.AddFlag('v', "verbose", "Verbose output");
+    parser.AddSubcommand("build", [&built](ArgParser& sub) {
+        ++built;
+        sub.AddIntArgument('j', "jobs", "Number of jobs");
+    });
+    parser.AddSubcommand("deploy", [&built](ArgParser& sub) {
+        ++built;
+        sub.AddStringArgument("target");
+    });
+
+    ASSERT_TRUE(parser.Parse(SplitString("tool -v build -j 4")));
+    ASSERT_TRUE(parser.GetFlag("verbose"));
+    ASSERT_EQ(parser.GetSubcommand(), "build");
+    ASSERT_EQ(parser.GetSubparser("build").GetIntValue("jobs"), 4);
+    ASSERT_EQ(built, 1);
+
+    ASSERT_TRUE(parser.Parse(SplitString("tool build --jobs=2")));
+    ASSERT_EQ(parser.GetSubparser("build").GetIntValue("jobs"), 2);
+    ASSERT_EQ(built, 1);
+
+    ASSERT_FALSE(parser.Parse(SplitString("tool deploy")));
+    ASSERT_EQ(built, 2);
+}
+
+
+TEST(ArgParserTestSuite, AbbreviationTest) {
+    ArgParser parser("My Parser");
+    parser.AllowAbbreviations();
+    parser.AddIntArgument("number", "Some Number");
+    parser.AddIntArgument("numeric", "Other Number").Default(0);
+    parser.AddStringArgument("param1");
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --numb=2 --par value")));
+    ASSERT_EQ(parser.GetIntValue("number"), 2);
+    ASSERT_EQ(parser.GetStringValue("param1"), "value");
+    ASSERT_FALSE(parser.Parse(SplitString("app --num=2 --par value")));
+    ASSERT_EQ(parser.GetParseError().code, ErrorCode::kAmbiguousArgument);
+    ASSERT_EQ(parser.GetErrorMessage(), "Ambiguous option --num could be --number or --numeric");
+    ASSERT_FALSE(parser.Parse(SplitString("app --x=2")));
+    ASSERT_EQ(parser.GetParseError().code, ErrorCode::kUnknownArgument);
+}
+
+
+TEST(ArgParserTestSuite, CompletionTest) {
+    ArgParser parser("My Parser");
+    parser.AddIntArgument("param2", "Second");
+    parser.AddIntArgument("param1", "First");
+    parser.AddFlag("flag");
+
+    ASSERT_EQ(parser.Complete("--par"), std::vector<std::string>({"--param1", "--param2"}));
+    ASSERT_EQ(parser.CompletionOutput("--p", CompletionShell::kBash), "--param1\n--param2\n");
+    ASSERT_EQ(parser.CompletionOutput("--param1", CompletionShell::kZsh), "--param1:First\n");
+    ASSERT_TRUE(parser.Complete("--x").empty());
+}
+
+
+TEST(ArgParserTestSuite, UnknownArgumentTest) {
+    ArgParser parser("My Parser");
+    parser.AddIntArgument("number", "Some Number").Default(1);
+    parser.AddStringArgument("input").Default("in.txt");
+    parser.AddFlag("numbers");
+
+    ASSERT_FALSE(parser.Parse(SplitString("app --numbr=2")));
+    ASSERT_EQ(parser.GetErrorMessage(), "Unknown option --numbr. Did you mean --number or --numbers?");
+
+    ASSERT_FALSE(parser.Parse(SplitString("app --output=2")));
+    ASSERT_EQ(parser.GetErrorMessage(), "Unknown option --output");
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --number=2")));
+    ASSERT_EQ(parser.GetErrorMessage(), "");
+    ASSERT_EQ(parser.SuggestParams("inptu"), std::vector<std::string>({"input"}));
+}
+
+
+TEST(ArgParserTestSuite, EndOfOptionsTest) {
+    ArgParser parser("My Parser");
+    std::vector<std::string> values;
+    parser.AddFlag('f', "flag", "Flag");
+    parser.AddStringArgument("files").MultiValue(1).Positional().StoreValues(values);
+
+    ASSERT_TRUE(parser.Parse(SplitString("app a -f -- -f --flag --unknown --")));
+    ASSERT_TRUE(parser.GetFlag("flag"));
+    ASSERT_EQ(values, std::vector<std::string>({"a", "-f", "--flag", "--unknown", "--"}));
+
+    ASSERT_FALSE(parser.Parse(SplitString("app -f --")));
+
+    parser.AddStringArgument('o', "output", "Output");
+    ASSERT_TRUE(parser.Parse(SplitString("app -o -- a -- -f")));
+    ASSERT_EQ(parser.GetStringValue("output"), "--");
+    ASSERT_FALSE(parser.GetFlag("flag"));
+    ASSERT_EQ(values, std::vector<std::string>({"a", "-f"}));
+}
+
+
+TEST(ArgParserTestSuite, RepeatedParsingResetTest) {
+    ArgParser parser("My Parser");
+    std::vector<int> values;
+    parser.AddFlag('f', "flag", "Flag");
+    parser.AddIntArgument('n', "number", "Some Number");
+    parser.AddIntArgument("Param1").MultiValue(2).Positional().StoreValues(values);
+    for (int i = 0; i < 100; ++i) {
+        parser.AddIntArgument("option" + std::to_string(i)).Default(i);
+    }
+
+    ASSERT_TRUE(parser.Parse(SplitString("app -f -n 1 2 3 --option70=7")));
+    ASSERT_EQ(parser.GetIntValue("option70"), 7);
+
+    ASSERT_FALSE(parser.Parse(SplitString("app 2 3")));
+    ASSERT_FALSE(parser.Parse(SplitString("app -n 1 2")));
+    ASSERT_TRUE(parser.Parse(SplitString("app -n 1 2 3")));
+    ASSERT_FALSE(parser.GetFlag("flag"));
+    ASSERT_EQ(parser.GetIntValue("option70"), 70);
+    ASSERT_EQ(values.size(), 2);
+}
+
+
+TEST(ArgParserTestSuite, ExpectedApiTest) {
+    ArgParser parser("My Parser");
+    parser.AddIntArgument('n', "number", "Some Number");
+    parser.AddStringArgument("input").MultiValue(0);
+    parser.AddFlag('f', "flag");
+
+    auto result = parser.TryParse(SplitString("app -f --number=x"));
+    ASSERT_FALSE(result.has_value());
+    ASSERT_EQ(result.error().code, ErrorCode::kInvalidValue);
+    ASSERT_EQ(result.error().token_index, 2);
+    ASSERT_EQ(parser.GetErrorMessage(), "Invalid value at argument 2");
+
+    result = parser.TryParse(SplitString("app -f"));
+    ASSERT_EQ(result.error().code, ErrorCode::kMissingArgument);
+    ASSERT_EQ(parser.GetErrorMessage(), "Missing required argument --number");
+
+    ASSERT_TRUE(parser.TryParse(SplitString("app -n 5 --input=a --input=b")).has_value());
+    ASSERT_EQ(parser.TryGetIntValue("number").value(), 5);
+    ASSERT_EQ(parser.TryGetStringValue("input", 1).value(), "b");
+    ASSERT_EQ(parser.TryGetStringValue("input", 2).error(), ErrorCode::kIndexOutOfRange);
+    ASSERT_EQ(parser.TryGetFlag("number").error(), ErrorCode::kTypeMismatch);
+    ASSERT_EQ(parser.TryGetFlag("other").error(), ErrorCode::kUnknownParam);
+    ASSERT_FALSE(parser.TryGetFlag("flag").value());
+
+    parser.AddIntArgument("first").Positional();
+    parser.AddIntArgument("second").Positional();
+    result = parser.TryParse(SplitString("app -n 5 1"));
+    ASSERT_EQ(result.error().code, ErrorCode::kInvalidSchema);
+    ASSERT_EQ(parser.GetErrorMessage(), "Invalid argument schema");
+}
+
+TEST(ArgParserTestSuite, MissingArgumentOrderTest) {
+    ArgParser parser("My Parser");
+    for (int i = 0; i < 50; ++i) {
+        parser.AddIntArgument("option" + std::to_string(i));
+    }
+    ASSERT_FALSE(parser.Parse(SplitString("app --option0=1")));
+    ASSERT_EQ(parser.GetErrorMessage(), "Missing required argument --option1");
+}
+
+
+TEST(ArgParserTestSuite, HelpRenderTest) {
+    ArgParser parser("My Parser");
+    parser.SetHelpWidth(50);
+    parser.AddHelp('h', "help", "Some Description about program");
+    parser.AddStringArgument('i', "input", "File path for input file").MultiValue(1);
+    parser.AddFlag('s', "flag1", "Use some logic with a rather long description").Default(true);
+    parser.AddIntArgument("number", "Some Number");
+
+    ASSERT_EQ(
+        parser.HelpDescription(),
+        "Parser name: My Parser\n"
+        "Some Description about program\n"
+        "\n"
+        "-i  --input=<string>  File path for input file\n"
+        "                      [repeated]\n"
+        "-s  --flag1           Use some logic with a rather\n"
+        "                      long description\n"
+        "    --number=<int>    Some Number\n"
+        "-h  --help            Display this help and exit\n"
+    );
+
+    std::ostringstream out;
+    parser.WriteHelp(out);
+    ASSERT_EQ(out.str(), parser.HelpText());
+
+    parser.AddIntArgument("other");
+    std::string text;
+    parser.WriteHelp([&text](std::string_view chunk) { text += chunk; });
+    ASSERT_NE(text.find("--other=<int>"), std::string::npos);
+}
+
+
+TEST(ArgParserTestSuite, ParseStatsTest) {
+    ArgParser parser("My Parser");
+    std::vector<int> values;
+    parser.AddFlag('a', "flag1");
+    parser.AddFlag('b', "flag2");
+    parser.AddIntArgument('n', "number", "Some Number");
+    parser.AddIntArgument("Param1").MultiValue(1).Positional().StoreValues(values);
+
+    ParseStats stats;
+    ASSERT_TRUE(parser.Parse(SplitString("app -ab --number 2 3 -- 4 5"), stats));
+    ASSERT_EQ(stats.flag_tokens, 1);
+    ASSERT_EQ(stats.argument_tokens, 1);
+    ASSERT_EQ(stats.value_tokens, 2);
+    ASSERT_EQ(stats.end_of_options_tokens, 2);
+    ASSERT_EQ(stats.values_dispatched, 4);
+    ASSERT_EQ(stats.name_lookups, 6);
+    ASSERT_EQ(stats.token_bytes, 15);
+    ASSERT_EQ(stats.long_tokens, 0);
+    ASSERT_EQ(values, std::vector<int>({3, 4, 5}));
+}
+
+
+TEST(ArgParserTestSuite, IntOverflowTest) {
+    ArgParser parser("My Parser");
+    parser.AddIntArgument("param1");
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --param1=-2147483648")));
+    ASSERT_EQ(parser.GetIntValue("param1"), -2147483648);
+    ASSERT_TRUE(parser.Parse(SplitString("app --param1=2147483647")));
+    ASSERT_FALSE(parser.Parse(SplitString("app --param1=2147483648")));
+    ASSERT_FALSE(parser.Parse(SplitString("app --param1=-")));
+}
+
+
+TEST(ArgParserTestSuite, IntRangeTest) {
+    ArgParser parser("My Parser");
+    parser.AddIntArgument("port").Range(1, 65535);
+    parser.AddIntArgument("N").MultiValue().Positional().Range(-10, 10);
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --port=80 -10 0 10")));
+    ASSERT_EQ(parser.GetIntValue("N", 2), 10);
+    ASSERT_FALSE(parser.Parse(SplitString("app --port=0 1")));
+    ASSERT_EQ(parser.GetParseError().code, ErrorCode::kInvalidValue);
+    ASSERT_FALSE(parser.Parse(SplitString("app --port=80 1 11 2 -11")));
+    ASSERT_EQ(parser.GetParseError().token_index, 3);
+    ASSERT_FALSE(parser.Parse(SplitString("app --port=80 -- 1 2 -11 x 12")));
+    ASSERT_EQ(parser.GetParseError().token_index, 5);
+    ASSERT_TRUE(parser.Parse(SplitString("app --port=80 -- 1 2 -3")));
+    ASSERT_EQ(parser.GetIntValue("N", 2), -3);
+    ASSERT_THROW(parser.AddIntArgument("bad").Range(2, 1), std::runtime_error);
+}
+
+
+TEST(ArgParserTestSuite, StringChoicesTest) {
+    ArgParser parser("My Parser");
+    parser.AddStringArgument("mode").Choices({"fast", "safe", "fast"});
+    parser.AddStringArgument("id").Pattern("[a-z]+[0-9]*").Default("x");
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --mode=safe --id=abc12")));
+    ASSERT_EQ(parser.GetStringValue("mode"), "safe");
+    ASSERT_FALSE(parser.Parse(SplitString("app --mode=slow")));
+    ASSERT_EQ(parser.GetParseError().token_index, 1);
+    ASSERT_FALSE(parser.Parse(SplitString("app --mode=fast --id=12abc")));
+    ASSERT_FALSE(parser.Parse(SplitString("app --mode=fas")));
+
+    std::ostringstream help;
+    parser.WriteHelp(help);
+    ASSERT_NE(help.str().find("choices = fast|safe"), std::string::npos);
+}
+
+TEST(ArgParserTestSuite, Utf8ValidationTest) {
+    ASSERT_TRUE(IsValidUtf8("plain ascii text, long enough for a block"));
+    ASSERT_TRUE(IsValidUtf8("\x24 \xC2\xA2 \xE2\x82\xAC \xF0\x90\x8D\x88"));
+    ASSERT_TRUE(IsValidUtf8("0123456789abcdef\xF4\x8F\xBF\xBF"));
+    ASSERT_FALSE(IsValidUtf8("\xC0\xAF"));
+    ASSERT_FALSE(IsValidUtf8("\xE0\x80\xAF"));
+    ASSERT_FALSE(IsValidUtf8("\xED\xA0\x80"));
+    ASSERT_FALSE(IsValidUtf8("\xF4\x90\x80\x80"));
+    ASSERT_FALSE(IsValidUtf8("0123456789abcdef0123\xE2\x82"));
+    ASSERT_FALSE(IsValidUtf8("\x80"));
+
+    ArgParser parser("My Parser");
+    parser.AddStringArgument("label").ValidateUtf8().Default("none");
+    parser.AddStringArgument("path").MultiValue(0).Positional().ValidateUtf8();
+
+    ASSERT_TRUE(parser.Parse({"app", "--label=\xD0\xBC\xD0\xB8\xD1\x80", "a", "b"}));
+    ASSERT_FALSE(parser.Parse({"app", "--label=\xFF"}));
+    ASSERT_EQ(parser.GetParseError().code, ErrorCode::kInvalidUtf8);
+    ASSERT_EQ(parser.GetParseError().token_index, 1);
+    ASSERT_FALSE(parser.Parse({"app", "--", "a", "b\xC3", "c\xFF"}));
+    ASSERT_EQ(parser.GetParseError().code, ErrorCode::kInvalidUtf8);
+    ASSERT_EQ(parser.GetParseError().token_index, 3);
+}
+
+TEST(ArgParserTestSuite, RegistrationLifetimeTest) {
+    ArgParser parser("My Parser");
+    {
+        std::string name = "a-name-that-only-lives-in-this-scope";
+        std::string description = "a description that only lives in this scope";
+        parser.AddIntArgument('n', name, description);
+        name.assign(name.size(), 'x');
+    }
+    {
+        // A plain char array is copied like a std::string, only
+        // Literal is kept as a view
+        char name[16] = "buffer-flag";
+        char description[16] = "from a buffer";
+        parser.AddFlag('b', name, description);
+        std::fill(std::begin(name), std::end(name) - 1, 'x');
+    }
+    parser.AddFlag('f', Literal("literal-flag"), Literal("literal description"));
+    parser.AddFlag('g', "copied-literal");
+
+    ASSERT_TRUE(parser.Parse(SplitString(
+        "app -f --a-name-that-only-lives-in-this-scope=3 --buffer-flag -g")));
+    ASSERT_EQ(parser.GetIntValue("a-name-that-only-lives-in-this-scope"), 3);
+    ASSERT_TRUE(parser.GetFlag("buffer-flag"));
+    ASSERT_TRUE(parser.GetFlag("copied-literal"));
+    ASSERT_EQ(parser.GetParamByFlag('b'), "buffer-flag");
+    ASSERT_EQ(parser.GetParamByFlag('f'), "literal-flag");
+
+    std::ostringstream help;
+    parser.WriteHelp(help);
+    ASSERT_NE(help.str().find("a description that only lives"), std::string::npos);
+    ASSERT_NE(help.str().find("from a buffer"), std::string::npos);
+}
+
+TEST(ArgParserTestSuite, ParallelPrepassTest) {
+    auto build = [](ArgParser& parser) {
+        parser.AddFlag('a', "all");
+        parser.AddIntArgument('n', "number").MultiValue(0);
+        parser.AddStringArgument('s', "string").Default("");
+        parser.AddIntArgument("values").MultiValue(0).Positional().Range(-100, 100);
+    };
+    std::vector<std::string> args = {"app"};
+    for (int i = 0; i < 40000; ++i) {
+        args.insert(args.end(), {"-n", std::to_string(i), "--string=" + std::to_string(i),
+            std::to_string(i % 100), "-an=" + std::to_string(-i)});
+    }
+    args.insert(args.end(), {"--", "-1", "2", "-3"});
+
+    ArgParser serial("My Parser");
+    build(serial);
+    serial.SetParallelThreshold(0);
+    ArgParser parallel("My Parser");
+    build(parallel);
+    ASSERT_GE(args.size(), ArgParser::kDefaultParallelThreshold);
+
+    ASSERT_TRUE(serial.Parse(args));
+    ASSERT_TRUE(parallel.Parse(args));
+    for (int ind : {0, 1, 79999}) {
+        ASSERT_EQ(parallel.GetIntValue("number", ind), serial.GetIntValue("number", ind));
+    }
+    ASSERT_EQ(parallel.GetIntValue("number", 79999), -39999);
+    ASSERT_EQ(parallel.GetStringValue("string"), "39999");
+    ASSERT_EQ(parallel.GetIntValue("values", 40002), -3);
+
+    args[150004] = "101";
+    args[190001] = "x";
+    ASSERT_FALSE(serial.Parse(args));
+    ASSERT_FALSE(parallel.Parse(args));
+    ASSERT_EQ(parallel.GetParseError().token_index, 150004);
+    ASSERT_EQ(parallel.GetParseError().token_index, serial.GetParseError().token_index);
+
+    // "-1" names a flag, but after "--" it is a positional value
+    ArgParser digit_flag("My Parser");
+    digit_flag.AddFlag('1', "one");
+    digit_flag.AddIntArgument("values").MultiValue().Positional();
+    digit_flag.SetParallelThreshold(1);
+    ASSERT_TRUE(digit_flag.Parse(SplitString("app 5 -- -1 7 8")));
+    ASSERT_FALSE(digit_flag.GetFlag("one"));
+    ASSERT_EQ(digit_flag.GetIntValue("values", 0), 5);
+    ASSERT_EQ(digit_flag.GetIntValue("values", 1), -1);
+    ASSERT_EQ(digit_flag.GetIntValue("values", 2), 7);
+    ASSERT_EQ(digit_flag.GetIntValue("values", 3), 8);
+}
+
+TEST(ArgParserTestSuite, IntSetTest) {
+    IntSet set;
+    for (int i = 0; i < 1000; i += 3) {
+        ASSERT_TRUE(set.Insert(i));
+    }
+    ASSERT_FALSE(set.Insert(300));
+    ASSERT_TRUE(set.IsDense());
+    ASSERT_TRUE(set.Contains(999));
+    ASSERT_FALSE(set.Contains(1000));
+    ASSERT_TRUE(set.Insert(-2000000000));
+    ASSERT_TRUE(set.Insert(2000000000));
+    ASSERT_FALSE(set.IsDense());
+    ASSERT_TRUE(set.Contains(-2000000000));
+    ASSERT_TRUE(set.Contains(3));
+    ASSERT_FALSE(set.Contains(4));
+    ASSERT_EQ(set.Size(), 336);
+    std::vector<int> values = set.Values();
+    ASSERT_TRUE(std::is_sorted(values.begin(), values.end()));
+    ASSERT_EQ(values.front(), -2000000000);
+    ASSERT_EQ(values.back(), 2000000000);
+    set.Clear();
+    ASSERT_TRUE(set.Empty());
+    ASSERT_FALSE(set.Contains(3));
+
+    // Ranges fill whole words and count only the new values
+    ASSERT_EQ(set.InsertRange(-70, 200), 271);
+    ASSERT_EQ(set.InsertRange(190, 260), 60);
+    ASSERT_EQ(set.InsertRange(5, 5), 0);
+    ASSERT_TRUE(set.IsDense());
+    ASSERT_EQ(set.Size(), 331);
+    ASSERT_FALSE(set.Contains(-71));
+    ASSERT_TRUE(set.Contains(-64));
+    ASSERT_TRUE(set.Contains(260));
+    ASSERT_FALSE(set.Contains(261));
+    IntSet single;
+    for (int i = -70; i <= 260; ++i) {
+        single.Insert(i);
+    }
+    ASSERT_EQ(set, single);
+
+    // Far away ranges move the set to the hash table
+    ASSERT_EQ(set.InsertRange(2000000000, 2000000009), 10);
+    ASSERT_FALSE(set.IsDense());
+    ASSERT_EQ(set.InsertRange(250, 270), 10);
+    ASSERT_EQ(set.Size(), 351);
+    ASSERT_TRUE(set.Contains(2000000009));
+    ASSERT_TRUE(set.Contains(270));
+}
+
+
+TEST(ArgParserTestSuite, IntSetArgumentTest) {
+    ArgParser parser("My Parser");
+    parser.AddIntSetArgument('c', "cpus", "CPU ids").Default("0");
+    parser.AddIntSetArgument("shards").MultiValue(0).Positional();
+
+    ASSERT_TRUE(parser.Parse(SplitString("app --cpus=0-3,8 -c 2-5 7 -3--1 7,9")));
+    ASSERT_EQ(parser.GetIntSet("cpus").Values(), std::vector<int>({0, 1, 2, 3, 4, 5, 8}));
+    ASSERT_EQ(parser.GetIntSet("shards").Values(), std::vector<int>({-3, -2, -1, 7, 9}));
+    ASSERT_TRUE(parser.GetIntSet("shards").Contains(-2));
+
+    ASSERT_TRUE(parser.Parse(SplitString("app")));
+    ASSERT_EQ(parser.GetIntSet("cpus").Values(), std::vector<int>({0}));
+    ASSERT_TRUE(parser.GetIntSet("shards").Empty());
+
+    for (const char* bad : {"app -c 3-1", "app -c 1,,2", "app -c 1,", "app -c 0-2000000"}) {
+        ASSERT_FALSE(parser.Parse(SplitString(bad))) << bad;
+        ASSERT_EQ(parser.GetParseError().token_index, 2) << bad;
+    }
+    ASSERT_EQ(parser.TryGetIntSet("cpus").value()->Size(), 1);
+
+    // One value stands for at most 2^20 values, whatever its items are
+    ASSERT_TRUE(parser.Parse({"app", "-c", "0-1048575"}));
+    ASSERT_EQ(parser.GetIntSet("cpus").Size(), 1048576);
+    std::string repeated = "0-1048575";
+    for (int i = 0; i < 50; ++i) {
+        repeated += ",0-1048575";
+    }
+    for (const std::string& bad : {std::string("0-1048575,0"),
+        std::string("0-524287,0-524287,7"), repeated})
+    {
+        ASSERT_FALSE(parser.Parse({"app", "-c", bad})) << bad;
+        ASSERT_EQ(parser.GetParseError().code, ErrorCode::kInvalidValue);
+        ASSERT_EQ(parser.GetParseError().token_index, 2);
+    }
+    ASSERT_THROW(parser.AddIntSetArgument("huge").Default("0-1048576"), std::runtime_error);
+    ASSERT_EQ(parser.TryGetIntSet("none").error(), ErrorCode::kUnknownParam);
+    ASSERT_THROW(parser.AddIntSetArgument("bad").Default("x"), std::runtime_error);
+}
+
+TEST(ArgParserTestSuite, MemoryUsageTest) {
+    ArgParser parser("My Parser");
+    parser.AddHelp('h', "help", "Some Description about program");
+    parser.AddFlag('v', "verbose");
+    parser.AddStringArgument('t', "tag", std::string(100, 'd')).Default(std::string(50, 'x'));
+    parser.AddIntArgument("N").MultiValue().Positional();
+
+    MemoryReport before = parser.MemoryUsage();
+    ASSERT_GE(before.schema, 150);
+    ASSERT_EQ(before.top_arguments.size(), 4);
+    ASSERT_EQ(before.top_arguments[0].first, "tag");
+
+    std::string args = "app";
+    for (int i = 0; i < 1000; ++i) {
+        args += " " + std::to_string(i);
+    }
+    ASSERT_TRUE(parser.Parse(SplitString(args)));
+    parser.HelpText();
+    MemoryReport after = parser.MemoryUsage(1);
+    ASSERT_GE(after.value_storage, before.value_storage + 1000 * sizeof(int));
+    ASSERT_GT(after.help_text, before.help_text);
+    ASSERT_EQ(after.top_arguments.size(), 1);
+    ASSERT_EQ(after.top_arguments[0].first, "N");
+    ASSERT_EQ(after.Total(), after.schema + after.name_index + after.help_text +
+        after.value_storage + after.parse_buffers);
+}
+
+TEST(ArgParserTestSuite, ResultCacheTest) {
+    ArgParser parser("My Parser");
+    int port = 0;
+    auto& port_arg = parser.AddIntArgument('p', "port").StoreValue(port).Default(80);
+    parser.AddStringArgument('t', "tag").MultiValue(0);
+    parser.AddFlag('v', "verbose");
+    parser.AddIntArgument("N").MultiValue().Positional();
+    parser.EnableResultCache(2);
+
+    std::vector<std::string> first = SplitString("app 1 2 3 -v -p 8080 --tag=a");
+    std::vector<std::string> second = SplitString("app 4 5 -p 7");
+    std::vector<std::string> bad = SplitString("app --unknown 1");
+    ASSERT_TRUE(parser.Parse(first));
+    ASSERT_TRUE(parser.Parse(second));
+    for (int i = 0; i < 2; ++i) {
+        ASSERT_TRUE(parser.Parse(first));
+        ASSERT_EQ(port, 8080);
+        ASSERT_TRUE(parser.GetFlag("verbose"));
+        ASSERT_EQ(parser.GetStringValue("tag"), "a");
+        ASSERT_EQ(parser.GetIntValue("N", 2), 3);
+
+        ASSERT_TRUE(parser.Parse(second));
+        ASSERT_EQ(port, 7);
+        ASSERT_FALSE(parser.GetFlag("verbose"));
+        ASSERT_EQ(parser.TryGetStringValue("tag").error(), ErrorCode::kNotInitialized);
+        ASSERT_EQ(parser.GetIntValue("N", 1), 5);
+    }
+    ASSERT_EQ(parser.GetResultCacheStats().hits, 4);
+    ASSERT_EQ(parser.GetResultCacheStats().misses, 2);
+
+    // The third vector evicts first, the least recently used one
+    ASSERT_FALSE(parser.Parse(bad));
+    ASSERT_FALSE(parser.Parse(bad));
+    ASSERT_EQ(parser.GetErrorMessage(), "Unknown option --unknown");
+    ASSERT_EQ(parser.GetParseError().token_index, 1);
+    ASSERT_TRUE(parser.Parse(first));
+    ASSERT_EQ(parser.GetResultCacheStats().hits, 5);
+    ASSERT_EQ(parser.GetResultCacheStats().misses, 4);
+    ASSERT_EQ(parser.GetResultCacheStats().evictions, 2);
+    ASSERT_EQ(parser.GetResultCacheStats().size, 2);
+
+    // A schema change drops the cached results
+    port_arg.Range(1, 100);
+    ASSERT_FALSE(parser.Parse(first));
+    ASSERT_EQ(parser.GetResultCacheStats().hits, 5);
+    ASSERT_EQ(parser.GetResultCacheStats().misses, 5);
+}
+
+TEST(ArgParserTestSuite, StaticParserTest) {
+    using Parser = StaticParser<
+        StaticFlag<"verbose", 'v'>,
+        StaticFlag<"all", 'a'>,
+        StaticInt<"port", 'p', 8080>,
+        StaticString<"host", 'h', "localhost">,
+        StaticMultiValue<StaticString<"tag", 't'>, 0>,
+        StaticPositional<StaticMultiValue<StaticInt<"N">>>>;
+    static_assert(Parser::FindName("port") == 2);
+    static_assert(Parser::FindName("por") == Parser::FindName("ports"));
+    static_assert(Parser::FindFlag('t') == 4);
+
+    Parser parser;
+    ASSERT_TRUE(parser.Parse(SplitString("app 1 -va --port=80 2 3 --tag x -t=y -- -4")));
+    ASSERT_TRUE(parser.Get<"verbose">());
+    ASSERT_TRUE(parser.Get<"all">());
+    ASSERT_EQ(parser.Get<"port">(), 80);
+    ASSERT_EQ(parser.Get<"host">(), "localhost");
+    ASSERT_EQ(parser.Get<"tag">(), std::vector<std::string>({"x", "y"}));
+    ASSERT_EQ(parser.Get<"N">(), std::vector<int>({1, 2, 3, -4}));
+
+    ASSERT_TRUE(parser.Parse(SplitString("app 5 -h example.com")));
+    ASSERT_FALSE(parser.Get<"verbose">());
+    ASSERT_EQ(parser.Get<"port">(), 8080);
+    ASSERT_EQ(parser.Get<"host">(), "example.com");
+    ASSERT_TRUE(parser.Get<"tag">().empty());
+}
+
+
+TEST(ArgParserTestSuite, StaticParserErrorsTest) {
+    StaticParser<StaticInt<"number", 'n'>, StaticFlag<"flag", 'f'>> parser;
+
+    ASSERT_FALSE(parser.Parse(SplitString("app -f")));
+    ASSERT_EQ(parser.GetParseError().code, ErrorCode::kMissingArgument);
+    ASSERT_FALSE(parser.Parse(SplitString("app -n x")));
+    ASSERT_EQ(parser.GetParseError().code, ErrorCode::kInvalidValue);
+    ASSERT_EQ(parser.GetParseError().token_index, 2);
+    ASSERT_FALSE(parser.Parse(SplitString("app --nmber=1")));
+    ASSERT_EQ(parser.GetParseError().code, ErrorCode::kUnknownArgument);
+    ASSERT_FALSE(parser.Parse(SplitString("app -n 1 2")));
+    ASSERT_EQ(parser.GetParseError().code, ErrorCode::kNoPositional);
+
+    ArgParser dynamic("My Parser");
+    dynamic.AddIntArgument('n', "number");
+    dynamic.AddFlag('f', "flag");
+    for (const char* line : {"app -n=3 -f", "app -fn 4", "app -n", "app --number= -f", "app -x",
+        "app --number= 5", "app -n= 5", "app -n -- 5"})
+    {
+        ASSERT_EQ(parser.Parse(SplitString(line)), dynamic.Parse(SplitString(line))) << line;
+    }
+    ASSERT_TRUE(parser.Parse(SplitString("app --number= 5")));
+    ASSERT_EQ(parser.Get<"number">(), 5);
+
+    // "--" right after an option that awaits a value is that value
+    StaticParser<StaticString<"host", 'h', "localhost">,
+        StaticMultiValue<StaticString<"tag", 't'>, 0>,
+        StaticPositional<StaticMultiValue<StaticInt<"N">, 0>>> strings;
+    ArgParser dynamic_strings("My Parser");
+    dynamic_strings.AddStringArgument('h', "host").Default("localhost");
+    dynamic_strings.AddStringArgument('t', "tag").MultiValue(0);
+    dynamic_strings.AddIntArgument("N").MultiValue(0).Positional();
+    for (const char* line : {"app -h --", "app -h -- 5", "app --host -- -- 5", "app -t --",
+        "app -t -- x", "app -t a -- 5", "app -t -- -- 5", "app 1 -- -h"})
+    {
+        ASSERT_EQ(strings.Parse(SplitString(line)), dynamic_strings.Parse(SplitString(line)))
+            << line;
+    }
+    ASSERT_TRUE(strings.Parse(SplitString("app -h --")));
+    ASSERT_EQ(strings.Get<"host">(), "--");
+    ASSERT_TRUE(strings.Parse(SplitString("app -t -- x")));
+    ASSERT_EQ(strings.Get<"tag">(), std::vector<std::string>({"--", "x"}));
+    ASSERT_TRUE(strings.Parse(SplitString("app -t a -- 5")));
+    ASSERT_EQ(strings.Get<"tag">(), std::vector<std::string>({"a"}));
+    ASSERT_EQ(strings.Get<"N">(), std::vector<int>({5}));
+}
+
+
+TEST(ArgParserTestSuite, BindTest) {
+    struct Options {
+        std::vector<int> values;
+        std::vector<std::string> names;
+        std::string output;
+        int level = 0;
+        bool verbose = false;
+    } opt;
+
+    ArgParser parser("My Parser");
+    auto bind = parser.Bind(opt);
+    bind.Int("N", &Options::values).MultiValue(1).Positional();
+    bind.String('n', "name", &Options::names).MultiValue(0);
+    bind.String("output", &Options::output).Default("out.txt");
+    bind.Int('l', "level", &Options::level);
+    bind.Flag('v', "verbose", &Options::verbose);
+
+    ASSERT_TRUE(parser.Parse(SplitString("app 1 -v -l 3 2 --name=a -n b")));
+    ASSERT_EQ(opt.values, std::vector<int>({1, 2}));
+    ASSERT_EQ(opt.names, std::vector<std::string>({"a", "b"}));
+    ASSERT_EQ(opt.output, "out.txt");
+    ASSERT_EQ(opt.level, 3);
+    ASSERT_TRUE(opt.verbose);
+
+    ASSERT_TRUE(parser.Parse(SplitString("app 5 -l 1 --output=o")));
+    ASSERT_EQ(opt.values, std::vector<int>({5}));
+    ASSERT_TRUE(opt.names.empty());
+    ASSERT_EQ(opt.output, "o");
+    ASSERT_FALSE(opt.verbose);
+}
+
+
+TEST(ArgParserTestSuite, RebindStorageTest) {
+    std::vector<int> first;
+    std::vector<int> second;
+    int value;
+    {
+        ArgParser parser("My Parser");
+        parser.AddIntArgument("N").MultiValue().Positional().StoreValues(first).StoreValues(second);
+        parser.AddIntArgument("value").StoreValue(value);
+        ASSERT_TRUE(parser.Parse(SplitString("app 1 2 --value=3")));
+    }
+    // Both vectors outlive the parser and only the last one gets values
+    ASSERT_TRUE(first.empty());
+    ASSERT_EQ(second, std::vector<int>({1, 2}));
+    ASSERT_EQ(value, 3);
+}
+
+
+TEST(ArgParserTestSuite, CommandLineTokenizerTest) {
+    CommandLineTokenizer tokenizer;
+    std::string line = "app plain 'single quoted' \"a \\\"b\\\" \\c\" es\\ caped a'b'\"c\" '' # comment\n"
+        "next\\\nline";
+
+    ASSERT_TRUE(tokenizer.Tokenize(line));
+    ASSERT_EQ(tokenizer.Tokens(), std::vector<std::string_view>({"app", "plain", "single quoted",
+        "a \"b\" \\c", "es caped", "abc", "", "nextline"}));
+    // Unquoted words point into the input
+    ASSERT_EQ(tokenizer.Tokens()[1].data(), line.data() + 4);
+
+    ASSERT_FALSE(tokenizer.Tokenize("app 'open"));
+    ASSERT_FALSE(tokenizer.Tokenize("app \"open\\\""));
+    ASSERT_FALSE(tokenizer.Tokenize("app end\\"));
+}
+
+
+TEST(ArgParserTestSuite, ParseCommandLineTest) {
+    ArgParser parser("My Parser");
+    parser.AddStringArgument('s', "str").MultiValue();
+    parser.AddIntArgument("N").MultiValue().Positional();
+    parser.AddFlag('f', "flag");
+
+    ASSERT_TRUE(parser.ParseCommandLine("app 1 --str='hello world' -f \"2\" -s x -- -3"));
+    ASSERT_EQ(parser.GetStringValue("str", 0), "hello world");
+    ASSERT_EQ(parser.GetStringValue("str", 1), "x");
+    ASSERT_EQ(parser.GetIntValue("N", 1), 2);
+    ASSERT_EQ(parser.GetIntValue("N", 2), -3);
+    ASSERT_TRUE(parser.GetFlag("flag"));
+
+    ASSERT_FALSE(parser.ParseCommandLine("app 1 --str='unterminated"));
+    ASSERT_EQ(parser.GetParseError().code, ErrorCode::kInvalidCommandLine);
+    ASSERT_EQ(parser.GetParseError().token_index, 2);
+    // The failure is what the parser reports afterwards too
+    std::string blob = parser.SerializeResult();
+    ParseResult result;
+    ASSERT_TRUE(result.Attach(blob));
+    ASSERT_FALSE(result.IsOk());
+
+    ASSERT_TRUE(parser.ParseCommandLine("app 1 -s x -f"));
+    ASSERT_FALSE(parser.ParseCommandLine("app 1 \"open"));
+    blob = parser.SerializeResult();
+    ASSERT_TRUE(result.Attach(blob));
+    ASSERT_FALSE(result.IsOk());
+    ASSERT_FALSE(result.GetFlag("flag"));
+}
+
+
+TEST(ArgParserTestSuite, SharedResultTest) {
+    ArgParser parser("My Parser");
+    parser.AddIntArgument("N").MultiValue().Positional();
+    parser.AddStringArgument('s', "str").Default("value");
+    parser.AddStringArgument("missing").Default("x").MultiValue(0);
+    parser.AddFlag('f', "flag");
+    parser.AddIntArgument('l', "level").Default(4);
+    ASSERT_TRUE(parser.Parse(SplitString("app 1 2 3 -f")));
+
+    int fd = parser.ExportResult();
+    ASSERT_GE(fd, 0);
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        ParseResult result;
+        bool is_ok = result.Attach(fd) && result.IsOk() && !result.Help() &&
+            result.TryGetIntValues("N")->size() == 3 && result.GetIntValue("N", 2) == 3 &&
+            result.GetStringValue("str") == "value" && result.GetFlag("flag");
+        _exit(is_ok ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    close(fd);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    std::string blob = parser.SerializeResult();
+    ParseResult result;
+    ASSERT_TRUE(result.Attach(blob));
+    ASSERT_EQ(result.TryGetIntValue("N", 3).error(), ErrorCode::kIndexOutOfRange);
+    ASSERT_EQ(result.TryGetStringValue("missing").error(), ErrorCode::kIndexOutOfRange);
+    ASSERT_EQ(result.TryGetFlag("N").error(), ErrorCode::kTypeMismatch);
+    ASSERT_EQ(result.TryGetFlag("none").error(), ErrorCode::kUnknownParam);
+    // Single-value arguments ignore the index, as in ArgParser
+    ASSERT_EQ(result.TryGetIntValue("level", 5), parser.TryGetIntValue("level", 5));
+    ASSERT_EQ(result.TryGetIntValue("level", 5).value(), 4);
+    ASSERT_EQ(result.TryGetStringValue("str", 2), parser.TryGetStringValue("str", 2));
+    ASSERT_EQ(result.TryGetStringValue("str", 2).value(), "value");
+    ASSERT_FALSE(result.Attach(std::string_view(blob).substr(0, blob.size() - 1)));
+}
+
+
+TEST(ArgParserTestSuite, ReparseTest) {
+    ArgParser parser("My Parser");
+    parser.AddIntArgument('n', "number").Default(1);
+    parser.AddStringArgument('s', "str").MultiValue(0);
+    parser.AddIntArgument("N").MultiValue().Positional();
+    parser.AddFlag('a', "all");
+    parser.AddFlag('b', "brief");
+    std::vector<std::string> old_args = SplitString("app 1 -a --number=5 -s x 2 -s y");
+    std::vector<std::string> new_args = SplitString("app 1 -a --number=6 -s x 2 -s y -b");
+    std::vector<std::string> changed;
+
+    ASSERT_TRUE(parser.Parse(old_args));
+    ASSERT_TRUE(parser.Reparse(old_args, new_args, changed));
+    std::sort(changed.begin(), changed.end());
+    ASSERT_EQ(changed, std::vector<std::string>({"brief", "number"}));
+    ASSERT_EQ(parser.GetIntValue("number"), 6);
+    ASSERT_TRUE(parser.GetFlag("brief"));
+    ASSERT_EQ(parser.GetStringValue("str", 2), "y");
+
+    // Dropping the only positional value breaks a requirement
+    old_args = new_args;
+    new_args = SplitString("app -b");
+    ASSERT_FALSE(parser.Reparse(old_args, new_args, changed));
+    std::sort(changed.begin(), changed.end());
+    ASSERT_EQ(changed, std::vector<std::string>({"N", "all", "number", "str"}));
+    ASSERT_EQ(parser.GetParseError().code, ErrorCode::kMissingArgument);
+    ASSERT_EQ(parser.GetIntValue("number"), 1);
+    ASSERT_FALSE(parser.GetFlag("all"));
+
+    // Unknown arguments fall back to a full parse
+    old_args = new_args;
+    new_args = SplitString("app 3 --unknown");
+    ASSERT_FALSE(parser.Reparse(old_args, new_args, changed));
+    ASSERT_EQ(parser.GetParseError().code, ErrorCode::kUnknownArgument);
+    ASSERT_TRUE(parser.Reparse(new_args, SplitString("app 3"), changed));
+    ASSERT_EQ(parser.GetIntValue("N"), 3);
+
+    // The last parse was not Parse(old_args), so everything is parsed again
+    ASSERT_TRUE(parser.Parse(SplitString("app 4 -n 7")));
+    ASSERT_TRUE(parser.Reparse(SplitString("app 4"), SplitString("app 4 -a"), changed));
+    ASSERT_EQ(changed.size(), 5);
+    ASSERT_EQ(parser.GetIntValue("number"), 1);
+    ASSERT_TRUE(parser.GetFlag("all"));
+
+    ASSERT_TRUE(parser.Reparse(SplitString("app 4 -a"), SplitString("app 4 -a"), changed));
+    ASSERT_TRUE(changed.empty());
+
+    // The kept trace outlives the vectors it was made from
+    ASSERT_TRUE(parser.Reparse(SplitString("app 4 -a"), SplitString("app 5 -a"), changed));
+    ASSERT_EQ(changed, std::vector<std::string>({"N"}));
+    ASSERT_TRUE(parser.Reparse(SplitString("app 5 -a"), SplitString("app 5 -a -n 2"), changed));
+    ASSERT_EQ(changed, std::vector<std::string>({"number"}));
+    ASSERT_EQ(parser.GetIntValue("number"), 2);
+    ASSERT_EQ(parser.GetIntValue("N"), 5);
+}
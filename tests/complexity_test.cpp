@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <lib/ArgParser.h>
+
+using namespace ArgumentParser;
+
+/*
+    Hostile-input scaling checks. Each scenario builds a command line of
+    a given number of bytes and is timed at two sizes; the time per input
+    byte at the large size may not exceed kMaxSlowdown times the time at
+    the small one. Linear parsing keeps the ratio near 1, a quadratic path
+    would make it near kScale. Timing depends on the machine load, so
+    ctest runs these only with -DARGPARSER_COMPLEXITY_TESTS=ON.
+*/
+
+namespace {
+
+const size_t kSmallSize = 1 << 12;
+const size_t kScale = 32;
+const double kMaxSlowdown = 4;
+const int kRepeats = 5;
+
+using ArgsBuilder = std::function<std::vector<std::string>(size_t)>;
+
+void BuildParser(ArgParser& parser) {
+    parser.AddFlag('a', "all");
+    parser.AddFlag('b', "brief");
+    parser.AddIntArgument('n', "number").MultiValue(0);
+    parser.AddStringArgument('s', "string").Default("value");
+    parser.AddIntArgument("values").MultiValue(0).Positional();
+    parser.AllowAbbreviations();
+}
+
+// Best of kRepeats parses (and error reports) of the same command line,
+// in nanoseconds per byte
+double NsPerByte(const ArgsBuilder& builder, size_t size) {
+    std::vector<std::string> args = builder(size);
+    ArgParser parser("My Parser");
+    BuildParser(parser);
+    double best = 0;
+    for (int i = 0; i < kRepeats; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        parser.Parse(args);
+        parser.GetErrorMessage();
+        double ns = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count();
+        best = i == 0 ? ns : std::min(best, ns);
+    }
+    return best / size;
+}
+
+void ExpectLinear(const ArgsBuilder& builder) {
+    double small = NsPerByte(builder, kSmallSize);
+    double large = NsPerByte(builder, kSmallSize * kScale);
+    EXPECT_LT(large, small * kMaxSlowdown) << "small: " << small << " ns/byte, large: "
+        << large << " ns/byte";
+}
+
+} // namespace
+
+
+TEST(ArgParserComplexityTestSuite, ClusteredFlagsTest) {
+    ExpectLinear([](size_t size) {
+        return std::vector<std::string>{"app", "-" + std::string(size, 'a')};
+    });
+    ExpectLinear([](size_t size) {
+        return std::vector<std::string>{"app", "-" + std::string(size, 'a') + "b=1"};
+    });
+}
+
+
+TEST(ArgParserComplexityTestSuite, LongNamesTest) {
+    ExpectLinear([](size_t size) {
+        return std::vector<std::string>{"app", "--" + std::string(size, 'x')};
+    });
+    ExpectLinear([](size_t size) {
+        return std::vector<std::string>{"app", "--number" + std::string(size, 'x') + "=1"};
+    });
+    ExpectLinear([](size_t size) {
+        return std::vector<std::string>{"app", "--string=" + std::string(size, '=')};
+    });
+}
+
+
+TEST(ArgParserComplexityTestSuite, LongValuesTest) {
+    ExpectLinear([](size_t size) {
+        return std::vector<std::string>{"app", "--number", std::string(size, '9')};
+    });
+    ExpectLinear([](size_t size) {
+        return std::vector<std::string>{"app", "-" + std::string(size, '-')};
+    });
+}
+
+
+TEST(ArgParserComplexityTestSuite, ManyTokensTest) {
+    ExpectLinear([](size_t size) {
+        std::vector<std::string> args = {"app"};
+        for (size_t i = 0; i < size / 4; ++i) {
+            args.push_back(i % 2 == 0 ? "-ab" : "--nu");
+        }
+        return args;
+    });
+    ExpectLinear([](size_t size) {
+        std::vector<std::string> args = {"app", "--"};
+        for (size_t i = 0; i < size / 2; ++i) {
+            args.push_back("7");
+        }
+        return args;
+    });
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <bin/Reduction.h>
+
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+/*
+    Reduce from the labwork binary. Inputs of more than two chunks of
+    kMinChunkSize (64Ki values) are split between threads, smaller ones
+    are reduced on the calling thread.
+*/
+
+namespace {
+
+// Enough values for four chunks
+const size_t kThreadedSize = 1 << 18;
+
+std::vector<int> PseudoRandomValues(size_t count) {
+    std::vector<int> values(count);
+    std::uint32_t state = 12345;
+    for (int& value : values) {
+        state = state * 1664525u + 1013904223u;
+        value = static_cast<int>(state >> 16) - (1 << 15);
+    }
+    return values;
+}
+
+} // namespace
+
+
+TEST(ReductionTestSuite, ProductOverflowTest) {
+    std::vector<int> values = {1 << 20, 1 << 20, 1 << 30};
+    ReductionResult result = Reduce(values, ReductionOp::kMult, 1);
+    ASSERT_TRUE(result.overflow);
+
+    values = {1 << 20, 1 << 20, 1 << 20};
+    result = Reduce(values, ReductionOp::kMult, 1);
+    ASSERT_FALSE(result.overflow);
+    ASSERT_EQ(result.value, std::int64_t(1) << 60);
+}
+
+TEST(ReductionTestSuite, ZeroFactorTest) {
+    // The product overflows before the zero comes
+    std::vector<int> values = {INT_MAX, INT_MAX, INT_MAX, 0, 5};
+    ReductionResult result = Reduce(values, ReductionOp::kMult, 1);
+    ASSERT_FALSE(result.overflow);
+    ASSERT_EQ(result.value, 0);
+
+    // The zero is in the last chunk, the overflow in the first one
+    values.assign(kThreadedSize, 2);
+    values.back() = 0;
+    result = Reduce(values, ReductionOp::kMult, 4);
+    ASSERT_FALSE(result.overflow);
+    ASSERT_EQ(result.value, 0);
+}
+
+TEST(ReductionTestSuite, MeanOfOddCountTest) {
+    std::vector<int> values = {1, 2, 4};
+    ReductionResult result = Reduce(values, ReductionOp::kMean, 1);
+    ASSERT_DOUBLE_EQ(result.mean, 7.0 / 3);
+    ASSERT_EQ(result.value, 7);
+}
+
+TEST(ReductionTestSuite, NegativeMinimumTest) {
+    std::vector<int> values = {3, -7, 5, INT_MIN + 1, 0};
+    ASSERT_EQ(Reduce(values, ReductionOp::kMin, 1).value, INT_MIN + 1);
+    ASSERT_EQ(Reduce(values, ReductionOp::kMax, 1).value, 5);
+
+    values = {-3, -7, -5};
+    ASSERT_EQ(Reduce(values, ReductionOp::kMin, 1).value, -7);
+    ASSERT_EQ(Reduce(values, ReductionOp::kMax, 1).value, -3);
+}
+
+TEST(ReductionTestSuite, SingleElementTest) {
+    std::vector<int> values = {-4};
+    ASSERT_EQ(Reduce(values, ReductionOp::kSum).value, -4);
+    ASSERT_EQ(Reduce(values, ReductionOp::kMult).value, -4);
+    ASSERT_EQ(Reduce(values, ReductionOp::kMin).value, -4);
+    ASSERT_EQ(Reduce(values, ReductionOp::kMax).value, -4);
+    ASSERT_DOUBLE_EQ(Reduce(values, ReductionOp::kMean).mean, -4.0);
+}
+
+TEST(ReductionTestSuite, ThreadCountTest) {
+    std::vector<int> values = PseudoRandomValues(kThreadedSize + 3);
+    // Small factors, so the product neither overflows at once nor hits zero
+    std::vector<int> factors(kThreadedSize, 1);
+    for (size_t i = 0; i < factors.size(); i += factors.size() / 30) {
+        factors[i] = -3;
+    }
+    ASSERT_EQ(Reduce(factors, ReductionOp::kMult, 4).value, -617673396283947);
+    for (ReductionOp op : {ReductionOp::kSum, ReductionOp::kMult, ReductionOp::kMin,
+        ReductionOp::kMax, ReductionOp::kMean})
+    {
+        for (const std::vector<int>* input : {&values, &factors}) {
+            ReductionResult single = Reduce(*input, op, 1);
+            for (int threads : {2, 3, 4, 7}) {
+                ReductionResult multi = Reduce(*input, op, threads);
+                ASSERT_EQ(multi.value, single.value);
+                ASSERT_EQ(multi.overflow, single.overflow);
+                ASSERT_DOUBLE_EQ(multi.mean, single.mean);
+            }
+        }
+    }
+}